@@ -0,0 +1,97 @@
+#!/bin/bash
+
+# Скрипт для сборки и запуска распределённого поиска дискретного логарифма
+# (ро-метод Полларда: координатор и рабочие процессы)
+
+# === Директории ===
+SRC_DIR="src"
+LIB_DIR="lib"
+BUILD_DIR="build"
+
+# === Компиляция ===
+compile() {
+    echo "Компиляция программы dlog..."
+
+    mkdir -p $BUILD_DIR
+
+    echo "[1/2] Компиляция библиотеки cryptography..."
+    g++ -fPIC -shared $LIB_DIR/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2 -pthread
+
+    echo "[2/2] Компиляция программы dlog..."
+    g++ $SRC_DIR/dlog.cpp -I$LIB_DIR -L$BUILD_DIR -lcryptography -o $BUILD_DIR/dlog -std=c++17 -Wall -O2 -pthread
+
+    if [ $? -eq 0 ]; then
+        echo "✅ Готово! Исполняемый файл: $BUILD_DIR/dlog"
+    else
+        echo "❌ Ошибка компиляции!"
+        exit 1
+    fi
+}
+
+# === Рабочие процессы на этой машине ===
+local_run() {
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/dlog local "$1" "$2" "$3" $4
+}
+
+# === Координатор (ждёт рабочих по TCP) ===
+serve() {
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/dlog serve "$1" "$2" "$3" "$4" "$5"
+}
+
+# === Рабочий (подключается к координатору) ===
+work() {
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/dlog work "$1" "$2"
+}
+
+# === Демонстрация: координатор и 3 рабочих на одной машине ===
+demo() {
+    compile
+    port=5555
+    echo "Задача: 5^x = 8 mod 23 и большая: 5^x = 1234567 mod 1000000007"
+    local_run 5 8 23 2
+    serve $port 3 5 1234567 1000000007 &
+    sleep 1
+    for i in 1 2 3; do
+        work 127.0.0.1 $port &
+    done
+    wait
+}
+
+# === Справка ===
+help() {
+    echo "Использование: $0 [команда]"
+    echo ""
+    echo "Команды:"
+    echo "  compile                        - компиляция программы dlog"
+    echo "  local a y p [workers]          - решить y = a^x mod p рабочими процессами этой машины"
+    echo "  serve port workers a y p       - координатор: ждать workers рабочих на порту port"
+    echo "  work host port                 - рабочий: подключиться к координатору"
+    echo "  demo                           - координатор и 3 рабочих на этой машине"
+    echo ""
+    echo "Примеры:"
+    echo "  $0 compile"
+    echo "  $0 local 5 1234567 1000000007 4"
+    echo "  $0 serve 5555 8 5 1234567 1000000007   # на узле-координаторе"
+    echo "  $0 work node1 5555                     # на каждом рабочем узле"
+}
+
+case "$1" in
+    "compile")
+        compile
+        ;;
+    "local")
+        local_run "$2" "$3" "$4" "$5"
+        ;;
+    "serve")
+        serve "$2" "$3" "$4" "$5" "$6"
+        ;;
+    "work")
+        work "$2" "$3"
+        ;;
+    "demo")
+        demo
+        ;;
+    *)
+        help
+        ;;
+esac
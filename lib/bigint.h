@@ -0,0 +1,520 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+//* Беззнаковое целое фиксированной длины: L слов по 64 бита, младшее слово первым.
+//*   BigUInt<16> — до 1024 бит, BigUInt<32> — до 2048, BigUInt<64> — до 4096.
+//* Умножение — школьное ниже BIGINT_KARATSUBA_LIMBS слов, выше — Карацуба
+//* (разбиение пополам до порога); возведение в квадрат — отдельной процедурой.
+//* Арифметика по модулю — форма Монтгомери, BigMontgomery<L> (R = 2^(64L)).
+
+//* Порог Карацубы в 64-битных словах: на меньших длинах школьное умножение быстрее
+//* (на x86-64 выигрыш появляется с 64 слов, т.е. с 4096-битных модулей)
+constexpr size_t BIGINT_KARATSUBA_LIMBS = 48;
+
+//* ---- операции над массивами слов ----
+
+// r = a + b (n слов), возвращает перенос
+inline uint64_t limbs_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+{
+    uint64_t c = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        unsigned __int128 s = (unsigned __int128)a[i] + b[i] + c;
+        r[i] = (uint64_t)s;
+        c = (uint64_t)(s >> 64);
+    }
+    return c;
+}
+
+// r = a - b (n слов), возвращает заём
+inline uint64_t limbs_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+{
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t d = a[i] - b[i];
+        uint64_t b1 = a[i] < b[i];
+        r[i] = d - borrow;
+        borrow = b1 | (d < borrow);
+    }
+    return borrow;
+}
+
+// r[0..n) += w, возвращает перенос из старшего слова
+inline uint64_t limbs_add_word(uint64_t *r, size_t n, uint64_t w)
+{
+    for (size_t i = 0; i < n && w; ++i)
+    {
+        r[i] += w;
+        w = r[i] < w;
+    }
+    return w;
+}
+
+// r[0..n) += a * b, возвращает старшее слово переноса
+inline uint64_t limbs_mul_add_word(uint64_t *r, const uint64_t *a, size_t n, uint64_t b)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        unsigned __int128 t = (unsigned __int128)a[i] * b + r[i] + carry;
+        r[i] = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    return carry;
+}
+
+inline int limbs_cmp(const uint64_t *a, const uint64_t *b, size_t n)
+{
+    for (size_t i = n; i-- > 0;)
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    return 0;
+}
+
+// r[0..2n) = a * b
+inline void limbs_mul_school(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+{
+    for (size_t i = 0; i < 2 * n; ++i)
+        r[i] = 0;
+    for (size_t i = 0; i < n; ++i)
+        r[i + n] = limbs_mul_add_word(r + i, a, n, b[i]);
+}
+
+// r[0..2n) = a^2: произведения a_i * a_j (i < j) считаются один раз и удваиваются,
+// затем добавляется диагональ a_i^2 — около n^2/2 умножений слов вместо n^2
+inline void limbs_sqr_school(uint64_t *r, const uint64_t *a, size_t n)
+{
+    for (size_t i = 0; i < 2 * n; ++i)
+        r[i] = 0;
+    for (size_t i = 0; i + 1 < n; ++i)
+        r[i + n] = limbs_mul_add_word(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+
+    uint64_t top = 0;
+    for (size_t i = 0; i < 2 * n; ++i)
+    {
+        uint64_t next = r[i] >> 63;
+        r[i] = (r[i] << 1) | top;
+        top = next;
+    }
+
+    uint64_t c = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        unsigned __int128 t = (unsigned __int128)a[i] * a[i];
+        unsigned __int128 s = (unsigned __int128)r[2 * i] + (uint64_t)t + c;
+        r[2 * i] = (uint64_t)s;
+        s = (unsigned __int128)r[2 * i + 1] + (uint64_t)(t >> 64) + (uint64_t)(s >> 64);
+        r[2 * i + 1] = (uint64_t)s;
+        c = (uint64_t)(s >> 64);
+    }
+}
+
+//* r[0..2N) = a * b; Карацуба с вычитанием: a0*b1 + a1*b0 = z0 + z2 + (a0 - a1)(b1 - b0),
+//* разности берутся по модулю со знаком, поэтому переносов в половинах нет
+template <size_t N>
+inline void limbs_mul(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    if constexpr (N < BIGINT_KARATSUBA_LIMBS || N % 2 != 0)
+        limbs_mul_school(r, a, b, N);
+    else
+    {
+        constexpr size_t H = N / 2;
+        limbs_mul<H>(r, a, b);                 // z0 = a0 * b0
+        limbs_mul<H>(r + N, a + H, b + H);     // z2 = a1 * b1
+
+        uint64_t da[H], db[H], mid[N], t[N];
+        bool neg = false;
+        if (limbs_cmp(a, a + H, H) >= 0)
+            limbs_sub(da, a, a + H, H);
+        else
+        {
+            limbs_sub(da, a + H, a, H);
+            neg = !neg;
+        }
+        if (limbs_cmp(b + H, b, H) >= 0)
+            limbs_sub(db, b + H, b, H);
+        else
+        {
+            limbs_sub(db, b, b + H, H);
+            neg = !neg;
+        }
+        limbs_mul<H>(mid, da, db);
+
+        // t = z0 + z2 ± |a0 - a1| * |b1 - b0| (N слов + перенос c)
+        uint64_t c = limbs_add(t, r, r + N, N);
+        if (neg)
+            c -= limbs_sub(t, t, mid, N);
+        else
+            c += limbs_add(t, t, mid, N);
+
+        c += limbs_add(r + H, r + H, t, N);
+        limbs_add_word(r + H + N, H, c);
+    }
+}
+
+//* r[0..2N) = a^2; Карацуба: 2*a0*a1 = z0 + z2 - (a0 - a1)^2
+template <size_t N>
+inline void limbs_sqr(uint64_t *r, const uint64_t *a)
+{
+    if constexpr (N < BIGINT_KARATSUBA_LIMBS || N % 2 != 0)
+        limbs_sqr_school(r, a, N);
+    else
+    {
+        constexpr size_t H = N / 2;
+        limbs_sqr<H>(r, a);
+        limbs_sqr<H>(r + N, a + H);
+
+        uint64_t da[H], mid[N], t[N];
+        if (limbs_cmp(a, a + H, H) >= 0)
+            limbs_sub(da, a, a + H, H);
+        else
+            limbs_sub(da, a + H, a, H);
+        limbs_sqr<H>(mid, da);
+
+        uint64_t c = limbs_add(t, r, r + N, N);
+        c -= limbs_sub(t, t, mid, N);
+
+        c += limbs_add(r + H, r + H, t, N);
+        limbs_add_word(r + H + N, H, c);
+    }
+}
+
+template <size_t L>
+struct BigUInt
+{
+    uint64_t limb[L] = {};
+
+    static constexpr int BITS = 64 * (int)L;
+
+    constexpr BigUInt() = default;
+    constexpr BigUInt(uint64_t x) { limb[0] = x; }
+
+    bool is_zero() const
+    {
+        for (size_t i = 0; i < L; ++i)
+            if (limb[i])
+                return false;
+        return true;
+    }
+    bool is_odd() const { return limb[0] & 1; }
+    bool bit(int i) const { return (limb[i >> 6] >> (i & 63)) & 1; }
+    int bit_length() const
+    {
+        for (size_t i = L; i-- > 0;)
+            if (limb[i])
+                return (int)(64 * i) + 64 - __builtin_clzll(limb[i]);
+        return 0;
+    }
+    void set_bit(int i) { limb[i >> 6] |= (uint64_t)1 << (i & 63); }
+
+    friend bool operator==(const BigUInt &a, const BigUInt &b) { return limbs_cmp(a.limb, b.limb, L) == 0; }
+    friend bool operator!=(const BigUInt &a, const BigUInt &b) { return limbs_cmp(a.limb, b.limb, L) != 0; }
+    friend bool operator<(const BigUInt &a, const BigUInt &b) { return limbs_cmp(a.limb, b.limb, L) < 0; }
+    friend bool operator>(const BigUInt &a, const BigUInt &b) { return limbs_cmp(a.limb, b.limb, L) > 0; }
+    friend bool operator<=(const BigUInt &a, const BigUInt &b) { return limbs_cmp(a.limb, b.limb, L) <= 0; }
+    friend bool operator>=(const BigUInt &a, const BigUInt &b) { return limbs_cmp(a.limb, b.limb, L) >= 0; }
+
+    // Сложение, вычитание и умножение — по модулю 2^BITS
+    BigUInt &operator+=(const BigUInt &o)
+    {
+        limbs_add(limb, limb, o.limb, L);
+        return *this;
+    }
+    BigUInt &operator-=(const BigUInt &o)
+    {
+        limbs_sub(limb, limb, o.limb, L);
+        return *this;
+    }
+    friend BigUInt operator+(BigUInt a, const BigUInt &b) { return a += b; }
+    friend BigUInt operator-(BigUInt a, const BigUInt &b) { return a -= b; }
+    friend BigUInt operator*(const BigUInt &a, const BigUInt &b)
+    {
+        uint64_t t[2 * L];
+        limbs_mul<L>(t, a.limb, b.limb);
+        BigUInt r;
+        for (size_t i = 0; i < L; ++i)
+            r.limb[i] = t[i];
+        return r;
+    }
+
+    // Умножение на слово на месте, возвращает перенос
+    uint64_t mul_word(uint64_t m)
+    {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < L; ++i)
+        {
+            unsigned __int128 t = (unsigned __int128)limb[i] * m + carry;
+            limb[i] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        return carry;
+    }
+    // Деление на слово на месте, возвращает остаток
+    uint64_t div_word(uint64_t d)
+    {
+        if (d == 0)
+            throw std::invalid_argument("BigUInt::div_word: division by zero");
+        unsigned __int128 rem = 0;
+        for (size_t i = L; i-- > 0;)
+        {
+            unsigned __int128 cur = (rem << 64) | limb[i];
+            limb[i] = (uint64_t)(cur / d);
+            rem = cur % d;
+        }
+        return (uint64_t)rem;
+    }
+    uint64_t mod_word(uint64_t d) const
+    {
+        if (d == 0)
+            throw std::invalid_argument("BigUInt::mod_word: division by zero");
+        unsigned __int128 rem = 0;
+        for (size_t i = L; i-- > 0;)
+            rem = ((rem << 64) | limb[i]) % d;
+        return (uint64_t)rem;
+    }
+
+    BigUInt &operator<<=(int s)
+    {
+        if (s >= BITS)
+            return *this = BigUInt();
+        int w = s >> 6, b = s & 63;
+        for (size_t i = L; i-- > 0;)
+        {
+            uint64_t v = i >= (size_t)w ? limb[i - w] << b : 0;
+            if (b && i >= (size_t)w + 1)
+                v |= limb[i - w - 1] >> (64 - b);
+            limb[i] = v;
+        }
+        return *this;
+    }
+    BigUInt &operator>>=(int s)
+    {
+        if (s >= BITS)
+            return *this = BigUInt();
+        int w = s >> 6, b = s & 63;
+        for (size_t i = 0; i < L; ++i)
+        {
+            uint64_t v = i + w < L ? limb[i + w] >> b : 0;
+            if (b && i + w + 1 < L)
+                v |= limb[i + w + 1] << (64 - b);
+            limb[i] = v;
+        }
+        return *this;
+    }
+
+    //* Байты big-endian длины len (len <= 8L; лишние старшие байты — нули)
+    static BigUInt from_bytes(const unsigned char *be, size_t len)
+    {
+        if (len > 8 * L)
+            throw std::invalid_argument("BigUInt::from_bytes: value too long");
+        BigUInt r;
+        for (size_t i = 0; i < len; ++i)
+        {
+            size_t pos = len - 1 - i; // номер байта от младшего
+            r.limb[pos >> 3] |= (uint64_t)be[i] << (8 * (pos & 7));
+        }
+        return r;
+    }
+    void to_bytes(unsigned char *be, size_t len) const
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            size_t pos = len - 1 - i;
+            be[i] = pos < 8 * L ? (unsigned char)(limb[pos >> 3] >> (8 * (pos & 7))) : 0;
+        }
+    }
+
+    //* Копия в другую ширину (старшие слова отбрасываются или дополняются нулями)
+    template <size_t M>
+    BigUInt<M> resize() const
+    {
+        BigUInt<M> r;
+        for (size_t i = 0; i < (L < M ? L : M); ++i)
+            r.limb[i] = limb[i];
+        return r;
+    }
+
+    std::string to_hex() const
+    {
+        static const char *digits = "0123456789abcdef";
+        std::string s;
+        for (int i = bit_length() - 1 - (bit_length() - 1) % 4; i >= 0; i -= 4)
+            s += digits[(limb[i >> 6] >> (i & 63)) & 0xF];
+        return s.empty() ? "0" : s;
+    }
+    static BigUInt from_hex(const std::string &s)
+    {
+        BigUInt r;
+        for (char ch : s)
+        {
+            int d;
+            if (ch >= '0' && ch <= '9')
+                d = ch - '0';
+            else if (ch >= 'a' && ch <= 'f')
+                d = ch - 'a' + 10;
+            else if (ch >= 'A' && ch <= 'F')
+                d = ch - 'A' + 10;
+            else
+                throw std::invalid_argument("BigUInt::from_hex: bad digit");
+            if (r.limb[L - 1] >> 60)
+                throw std::invalid_argument("BigUInt::from_hex: value too long");
+            r <<= 4;
+            r.limb[0] |= (uint64_t)d;
+        }
+        return r;
+    }
+};
+
+//* Полное произведение (2L слов)
+template <size_t L>
+BigUInt<2 * L> mul_full(const BigUInt<L> &a, const BigUInt<L> &b)
+{
+    BigUInt<2 * L> r;
+    limbs_mul<L>(r.limb, a.limb, b.limb);
+    return r;
+}
+
+//* Контекст модуля для длинной арифметики Монтгомери (R = 2^(64L)).
+//* Модуль нечётный; аргументы mul/sqr — в форме Монтгомери и меньше модуля.
+template <size_t L>
+struct BigMontgomery
+{
+    BigUInt<L> n;
+    uint64_t n_neg = 0; // -n^{-1} mod 2^64
+    BigUInt<L> r;       // R mod n (единица в форме Монтгомери)
+    BigUInt<L> r2;      // R^2 mod n
+
+    explicit BigMontgomery(const BigUInt<L> &mod) : n(mod)
+    {
+        if (!mod.is_odd() || mod <= BigUInt<L>(1))
+            throw std::invalid_argument("BigMontgomery: mod must be odd and > 1");
+        uint64_t inv = mod.limb[0];
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - mod.limb[0] * inv;
+        n_neg = 0 - inv;
+
+        // Деления нет: R mod n и R^2 mod n — удвоениями по модулю, начиная с 1
+        r = BigUInt<L>(1);
+        for (int i = 0; i < BigUInt<L>::BITS; ++i)
+            r = add(r, r);
+        r2 = r;
+        for (int i = 0; i < BigUInt<L>::BITS; ++i)
+            r2 = add(r2, r2);
+    }
+
+    BigUInt<L> add(const BigUInt<L> &a, const BigUInt<L> &b) const
+    {
+        BigUInt<L> s;
+        uint64_t c = limbs_add(s.limb, a.limb, b.limb, L);
+        if (c || s >= n)
+            limbs_sub(s.limb, s.limb, n.limb, L);
+        return s;
+    }
+    BigUInt<L> sub(const BigUInt<L> &a, const BigUInt<L> &b) const
+    {
+        BigUInt<L> s;
+        if (limbs_sub(s.limb, a.limb, b.limb, L))
+            limbs_add(s.limb, s.limb, n.limb, L);
+        return s;
+    }
+
+    // t * R^{-1} mod n для t < n * R (2L слов, содержимое t портится):
+    // по слову обнуляем младшую половину, прибавляя кратные n
+    BigUInt<L> reduce(uint64_t *t) const
+    {
+        uint64_t top = 0;
+        for (size_t i = 0; i < L; ++i)
+        {
+            uint64_t m = t[i] * n_neg;
+            uint64_t c = limbs_mul_add_word(t + i, n.limb, L, m);
+            top += limbs_add_word(t + i + L, L - i, c);
+        }
+        BigUInt<L> res;
+        for (size_t i = 0; i < L; ++i)
+            res.limb[i] = t[i + L];
+        if (top || res >= n)
+            limbs_sub(res.limb, res.limb, n.limb, L);
+        return res;
+    }
+    BigUInt<L> mul(const BigUInt<L> &a, const BigUInt<L> &b) const
+    {
+        uint64_t t[2 * L];
+        limbs_mul<L>(t, a.limb, b.limb);
+        return reduce(t);
+    }
+    BigUInt<L> sqr(const BigUInt<L> &a) const
+    {
+        uint64_t t[2 * L];
+        limbs_sqr<L>(t, a.limb);
+        return reduce(t);
+    }
+    // a < R: a * R^2 * R^{-1} < 2n, поэтому исходное значение может быть и >= n
+    BigUInt<L> to_mont(const BigUInt<L> &a) const { return mul(a, r2); }
+    BigUInt<L> from_mont(const BigUInt<L> &a) const
+    {
+        uint64_t t[2 * L] = {};
+        for (size_t i = 0; i < L; ++i)
+            t[i] = a.limb[i];
+        return reduce(t);
+    }
+
+    //* base^exp mod n: скользящее окно слева направо, таблица нечётных степеней
+    BigUInt<L> pow(const BigUInt<L> &base, const BigUInt<L> &exp) const
+    {
+        int bits = exp.bit_length();
+        if (bits == 0)
+            return from_mont(r);
+        const int w = bits <= 6 ? 1 : bits <= 24 ? 3 : bits <= 256 ? 4 : 5;
+
+        BigUInt<L> odd[16];
+        odd[0] = to_mont(base);
+        if (w > 1)
+        {
+            BigUInt<L> b2 = sqr(odd[0]);
+            for (int k = 1; k < (1 << (w - 1)); ++k)
+                odd[k] = mul(odd[k - 1], b2);
+        }
+
+        BigUInt<L> result = r;
+        bool started = false;
+        for (int i = bits - 1; i >= 0;)
+        {
+            if (!exp.bit(i))
+            {
+                result = sqr(result);
+                --i;
+                continue;
+            }
+            int j = i - w + 1 > 0 ? i - w + 1 : 0;
+            while (!exp.bit(j))
+                ++j;
+            int digit = 0;
+            for (int k = i; k >= j; --k)
+                digit = (digit << 1) | (int)exp.bit(k);
+            if (started)
+            {
+                for (int k = j; k <= i; ++k)
+                    result = sqr(result);
+                result = mul(result, odd[digit >> 1]);
+            }
+            else
+            {
+                result = odd[digit >> 1];
+                started = true;
+            }
+            i = j - 1;
+        }
+        return from_mont(result);
+    }
+};
+
+//* base^exp mod mod для длинных чисел (модуль нечётный)
+template <size_t L>
+BigUInt<L> mod_pow(const BigUInt<L> &base, const BigUInt<L> &exp, const BigUInt<L> &mod)
+{
+    return BigMontgomery<L>(mod).pow(base, exp);
+}
@@ -5,13 +5,287 @@
 #include <cmath>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <limits>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <numeric>
+#include <fstream>
 
-// Статический генератор псевдослучайных чисел
-static std::mt19937_64 CRYPTO_RNG((unsigned)time(nullptr));
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif
 
-// Массив малых простых чисел
-static const int SMALL_PRIMES_ARR[] = {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRYPTO_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+//* ---- Генератор ChaCha20 ----
+// Блоки считаются по CHACHA_LANES сразу: состояние хранится по словам (x[слово][блок]),
+// каждый раунд — одинаковые операции над соседними блоками. На AVX2 блоки лежат в ланах
+// регистров (выбор по CPU во время выполнения); выход обоих вариантов совпадает.
+
+constexpr int CHACHA_LANES = 8;
+constexpr size_t CHACHA_BLOCK_WORDS = 8; // 64 байта блока = 8 слов по 64 бита
+static_assert(CryptoRng::BUFFER_WORDS % (CHACHA_LANES * CHACHA_BLOCK_WORDS) == 0,
+              "CryptoRng buffer must hold whole lane groups");
+
+static inline uint32_t rotl32(uint32_t v, int c)
+{
+    return (v << c) | (v >> (32 - c));
+}
+
+static const uint32_t CHACHA_SIGMA[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574}; // "expand 32-byte k"
+
+//* nblocks (кратно CHACHA_LANES) блоков ChaCha20 с номерами counter, counter + 1, ...
+//* Слова 12-13 — счётчик, 14-15 — номер потока (исходный вариант Бернштейна)
+static void chacha20_blocks_scalar(const uint32_t key[8], unsigned long long counter, unsigned long long stream,
+                            unsigned long long *out, size_t nblocks)
+{
+    for (size_t b = 0; b < nblocks; b += CHACHA_LANES)
+    {
+        uint32_t in[16][CHACHA_LANES], x[16][CHACHA_LANES];
+        for (int l = 0; l < CHACHA_LANES; ++l)
+        {
+            for (int w = 0; w < 4; ++w)
+                in[w][l] = CHACHA_SIGMA[w];
+            for (int w = 0; w < 8; ++w)
+                in[4 + w][l] = key[w];
+            unsigned long long c = counter + b + l;
+            in[12][l] = (uint32_t)c;
+            in[13][l] = (uint32_t)(c >> 32);
+            in[14][l] = (uint32_t)stream;
+            in[15][l] = (uint32_t)(stream >> 32);
+        }
+        std::memcpy(x, in, sizeof(x));
+
+#define CHACHA_QR(A, B, C, D)                            \
+    for (int l = 0; l < CHACHA_LANES; ++l)               \
+    {                                                    \
+        x[A][l] += x[B][l];                              \
+        x[D][l] = rotl32(x[D][l] ^ x[A][l], 16);         \
+        x[C][l] += x[D][l];                              \
+        x[B][l] = rotl32(x[B][l] ^ x[C][l], 12);         \
+        x[A][l] += x[B][l];                              \
+        x[D][l] = rotl32(x[D][l] ^ x[A][l], 8);          \
+        x[C][l] += x[D][l];                              \
+        x[B][l] = rotl32(x[B][l] ^ x[C][l], 7);          \
+    }
+        for (int round = 0; round < 10; ++round)
+        {
+            CHACHA_QR(0, 4, 8, 12)
+            CHACHA_QR(1, 5, 9, 13)
+            CHACHA_QR(2, 6, 10, 14)
+            CHACHA_QR(3, 7, 11, 15)
+            CHACHA_QR(0, 5, 10, 15)
+            CHACHA_QR(1, 6, 11, 12)
+            CHACHA_QR(2, 7, 8, 13)
+            CHACHA_QR(3, 4, 9, 14)
+        }
+#undef CHACHA_QR
+
+        // блок l — 16 слов x[w][l] + in[w][l] в порядке little-endian
+        for (int l = 0; l < CHACHA_LANES; ++l)
+            for (int w = 0; w < 16; w += 2)
+                out[(b + l) * CHACHA_BLOCK_WORDS + w / 2] =
+                    (unsigned long long)(x[w][l] + in[w][l]) |
+                    (unsigned long long)(x[w + 1][l] + in[w + 1][l]) << 32;
+    }
+}
+
+#ifdef CRYPTO_X86_SIMD
+__attribute__((target("avx2"))) static inline __m256i rotl32_avx2(__m256i v, int c)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(v, c), _mm256_srli_epi32(v, 32 - c));
+}
+
+//* Восемь блоков за проход: лана l регистра x[w] — слово w блока counter + l.
+//* Повороты на 16 и 8 — перестановкой байтов, на 12 и 7 — сдвигами
+__attribute__((target("avx2"))) static void chacha20_blocks_avx2(const uint32_t key[8], unsigned long long counter,
+                                                               unsigned long long stream, unsigned long long *out,
+                                                               size_t nblocks)
+{
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                          3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    alignas(32) uint32_t lanes[16][CHACHA_LANES];
+    for (size_t b = 0; b < nblocks; b += CHACHA_LANES)
+    {
+        __m256i in[16], x[16];
+        for (int w = 0; w < 4; ++w)
+            in[w] = _mm256_set1_epi32((int)CHACHA_SIGMA[w]);
+        for (int w = 0; w < 8; ++w)
+            in[4 + w] = _mm256_set1_epi32((int)key[w]);
+        alignas(32) uint32_t lo[CHACHA_LANES], hi[CHACHA_LANES];
+        for (int l = 0; l < CHACHA_LANES; ++l)
+        {
+            unsigned long long c = counter + b + l;
+            lo[l] = (uint32_t)c;
+            hi[l] = (uint32_t)(c >> 32);
+        }
+        in[12] = _mm256_load_si256((const __m256i *)lo);
+        in[13] = _mm256_load_si256((const __m256i *)hi);
+        in[14] = _mm256_set1_epi32((int)(uint32_t)stream);
+        in[15] = _mm256_set1_epi32((int)(uint32_t)(stream >> 32));
+        for (int w = 0; w < 16; ++w)
+            x[w] = in[w];
+
+#define CHACHA_QR_AVX2(A, B, C, D)                                         \
+    x[A] = _mm256_add_epi32(x[A], x[B]);                                   \
+    x[D] = _mm256_shuffle_epi8(_mm256_xor_si256(x[D], x[A]), rot16);       \
+    x[C] = _mm256_add_epi32(x[C], x[D]);                                   \
+    x[B] = rotl32_avx2(_mm256_xor_si256(x[B], x[C]), 12);                  \
+    x[A] = _mm256_add_epi32(x[A], x[B]);                                   \
+    x[D] = _mm256_shuffle_epi8(_mm256_xor_si256(x[D], x[A]), rot8);        \
+    x[C] = _mm256_add_epi32(x[C], x[D]);                                   \
+    x[B] = rotl32_avx2(_mm256_xor_si256(x[B], x[C]), 7);
+        for (int round = 0; round < 10; ++round)
+        {
+            CHACHA_QR_AVX2(0, 4, 8, 12)
+            CHACHA_QR_AVX2(1, 5, 9, 13)
+            CHACHA_QR_AVX2(2, 6, 10, 14)
+            CHACHA_QR_AVX2(3, 7, 11, 15)
+            CHACHA_QR_AVX2(0, 5, 10, 15)
+            CHACHA_QR_AVX2(1, 6, 11, 12)
+            CHACHA_QR_AVX2(2, 7, 8, 13)
+            CHACHA_QR_AVX2(3, 4, 9, 14)
+        }
+#undef CHACHA_QR_AVX2
+
+        for (int w = 0; w < 16; ++w)
+            _mm256_store_si256((__m256i *)lanes[w], _mm256_add_epi32(x[w], in[w]));
+        for (int l = 0; l < CHACHA_LANES; ++l)
+            for (int w = 0; w < 16; w += 2)
+                out[(b + l) * CHACHA_BLOCK_WORDS + w / 2] =
+                    (unsigned long long)lanes[w][l] | (unsigned long long)lanes[w + 1][l] << 32;
+    }
+}
+#endif
+
+static void chacha20_blocks(const uint32_t key[8], unsigned long long counter, unsigned long long stream,
+                            unsigned long long *out, size_t nblocks)
+{
+#ifdef CRYPTO_X86_SIMD
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+        return chacha20_blocks_avx2(key, counter, stream, out, nblocks);
+#endif
+    chacha20_blocks_scalar(key, counter, stream, out, nblocks);
+}
+
+CryptoRng::CryptoRng()
+{
+    std::random_device rd;
+    for (auto &k : key)
+        k = rd();
+}
+
+CryptoRng::CryptoRng(unsigned long long seed, unsigned long long stream)
+{
+    reseed(seed, stream);
+}
+
+void CryptoRng::reseed(unsigned long long seed, unsigned long long stream_id)
+{
+    // ключ — 4 слова splitmix64 от зерна: близкие зёрна дают несвязанные ключи
+    for (int i = 0; i < 4; ++i)
+    {
+        unsigned long long z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        key[2 * i] = (uint32_t)z;
+        key[2 * i + 1] = (uint32_t)(z >> 32);
+    }
+    counter = 0;
+    stream = stream_id;
+    pos = BUFFER_WORDS;
+}
+
+void CryptoRng::refill()
+{
+    const size_t blocks = BUFFER_WORDS / CHACHA_BLOCK_WORDS;
+    chacha20_blocks(key, counter, stream, buf, blocks);
+    counter += blocks;
+    // стирание ключа: новый ключ — первые 256 бит выхода, они же не выдаются
+    for (int i = 0; i < 4; ++i)
+    {
+        key[2 * i] = (uint32_t)buf[i];
+        key[2 * i + 1] = (uint32_t)(buf[i] >> 32);
+    }
+    pos = 4;
+}
+
+void CryptoRng::fill(unsigned long long *out, size_t n)
+{
+    while (n > 0)
+    {
+        if (pos == BUFFER_WORDS)
+            refill();
+        size_t take = std::min(n, BUFFER_WORDS - pos);
+        std::memcpy(out, buf + pos, take * sizeof(*out));
+        pos += take;
+        out += take;
+        n -= take;
+    }
+}
+
+// Зерно random_seed и номер потока для следующего созданного генератора;
+// пока зерно не задано, ключи берутся из random_device
+static std::mutex RNG_SEED_MUTEX;
+static bool RNG_SEEDED = false;
+static unsigned long long RNG_SEED = 0, RNG_NEXT_STREAM = 0;
+
+static std::unique_ptr<CryptoRng> make_thread_rng()
+{
+    std::lock_guard<std::mutex> lock(RNG_SEED_MUTEX);
+    if (RNG_SEEDED)
+        return std::make_unique<CryptoRng>(RNG_SEED, RNG_NEXT_STREAM++);
+    return std::make_unique<CryptoRng>();
+}
+
+CryptoRng &crypto_rng()
+{
+    // в куче: буфер в 4 КиБ не раздувает TLS каждого потока процесса
+    thread_local std::unique_ptr<CryptoRng> rng = make_thread_rng();
+    return *rng;
+}
+
+void random_seed(unsigned long long seed)
+{
+    CryptoRng &rng = crypto_rng();
+    std::lock_guard<std::mutex> lock(RNG_SEED_MUTEX);
+    RNG_SEEDED = true;
+    RNG_SEED = seed;
+    RNG_NEXT_STREAM = 1;
+    rng.reseed(seed, 0);
+}
+
+//* Случайное число из [lo, hi] генератора потока
+static long long random_range(long long lo, long long hi)
+{
+    return std::uniform_int_distribution<long long>(lo, hi)(crypto_rng());
+}
+
+// Массив малых простых чисел (объявлен в заголовке — нужен шаблонам длинной арифметики)
+const int SMALL_PRIMES_ARR[] = {
     2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71,
     73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137, 139, 149, 151,
     157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223, 227, 229, 233,
@@ -24,13 +298,174 @@ static const int SMALL_PRIMES_ARR[] = {
     821, 823, 827, 829, 839, 853, 857, 859, 863, 877, 881, 883, 887, 907, 911,
     919, 929, 937, 941, 947, 953, 967, 971, 977, 983, 991, 997};
 // Размер массива малых простых чисел
-static const int SMALL_PRIMES_COUNT = sizeof(SMALL_PRIMES_ARR) / sizeof(SMALL_PRIMES_ARR[0]);
+const int SMALL_PRIMES_COUNT = sizeof(SMALL_PRIMES_ARR) / sizeof(SMALL_PRIMES_ARR[0]);
+
+unsigned long long random_u64()
+{
+    return crypto_rng()();
+}
+
+void random_u64(unsigned long long *out, size_t n)
+{
+    crypto_rng().fill(out, n);
+}
+
+MontgomeryContext::MontgomeryContext(unsigned long long mod)
+{
+    if (mod < 3 || (mod & 1) == 0 || mod >> 63)
+        throw std::invalid_argument("MontgomeryContext: mod must be odd, > 1 and < 2^63");
+    n = mod;
+
+    // n^{-1} mod 2^64 по Ньютону: каждая итерация удваивает число верных бит
+    unsigned long long inv = mod; // верно по модулю 2^3 для нечётного mod
+    for (int i = 0; i < 5; ++i)
+        inv *= 2 - mod * inv;
+    n_neg = 0 - inv;
+
+    r = (unsigned long long)(((unsigned __int128)1 << 64) % mod);
+    r2 = (unsigned long long)(((unsigned __int128)r * r) % mod);
+}
+
+//* Ширина скользящего окна по битовой длине показателя: окно w стоит
+//* 2^(w-1) умножений на таблицу нечётных степеней, но сокращает число умножений
+//* в основном цикле примерно с bits/2 до bits/(w+1)
+static int sliding_window_width(int bits)
+{
+    if (bits <= 6)
+        return 1;
+    if (bits <= 24)
+        return 3;
+    return 4;
+}
+
+static int bit_length(unsigned long long x)
+{
+    return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+//* Перекодирование показателя в скользящие окна (слева направо).
+//* Первый шаг задаёт начальное значение (без возведений в квадрат),
+//* последний может иметь digit = 0 — хвост из нулевых бит.
+static std::vector<ExpStep> recode_sliding_window(unsigned long long exp, int w)
+{
+    std::vector<ExpStep> steps;
+    int zeros = 0;
+    for (int i = bit_length(exp) - 1; i >= 0;)
+    {
+        if (((exp >> i) & 1) == 0)
+        {
+            ++zeros;
+            --i;
+            continue;
+        }
+        int j = std::max(i - w + 1, 0);
+        while (((exp >> j) & 1) == 0)
+            ++j;
+        int len = i - j + 1;
+        int digit = (int)((exp >> j) & ((1ULL << len) - 1));
+        steps.push_back({zeros + len, digit});
+        zeros = 0;
+        i = j - 1;
+    }
+    if (zeros)
+        steps.push_back({zeros, 0});
+    return steps;
+}
+
+//* Выполнение перекодированного показателя: odd[k] = base^(2k+1) в форме Монтгомери
+static unsigned long long pow_recoded_mont(const MontgomeryContext &ctx, const unsigned long long *odd,
+                                           const ExpStep *steps, size_t nsteps)
+{
+    if (nsteps == 0)
+        return ctx.r;
+    unsigned long long result = odd[steps[0].digit >> 1];
+    for (size_t s = 1; s < nsteps; ++s)
+    {
+        for (int k = 0; k < steps[s].squarings; ++k)
+            result = ctx.sqr(result);
+        if (steps[s].digit)
+            result = ctx.mul(result, odd[steps[s].digit >> 1]);
+    }
+    return result;
+}
+
+//* Таблица нечётных степеней base^1, base^3, ..., base^(2^w - 1) в форме Монтгомери
+static void odd_powers_mont(const MontgomeryContext &ctx, unsigned long long base_mont, int w, unsigned long long *odd)
+{
+    odd[0] = base_mont;
+    if (w == 1)
+        return;
+    unsigned long long b2 = ctx.sqr(base_mont);
+    for (int k = 1; k < (1 << (w - 1)); ++k)
+        odd[k] = ctx.mul(odd[k - 1], b2);
+}
+
+//* Возведение в степень в форме Монтгомери с готовым контекстом модуля
+//* (скользящее окно слева направо, перекодирование на лету)
+long long mod_pow(long long base, long long exp, const MontgomeryContext &ctx)
+{
+    if (exp < 0)
+        throw std::invalid_argument("mod_pow: exp must be >= 0");
+    long long b = base % (long long)ctx.n;
+    if (b < 0)
+        b += (long long)ctx.n;
+
+    unsigned long long e = (unsigned long long)exp;
+    int bits = bit_length(e);
+    int w = sliding_window_width(bits);
+    unsigned long long odd[1 << 3];
+    odd_powers_mont(ctx, ctx.to_mont((unsigned long long)b), w, odd);
+
+    unsigned long long result = ctx.r;
+    bool started = false;
+    for (int i = bits - 1; i >= 0;)
+    {
+        if (((e >> i) & 1) == 0)
+        {
+            result = ctx.sqr(result);
+            --i;
+            continue;
+        }
+        int j = std::max(i - w + 1, 0);
+        while (((e >> j) & 1) == 0)
+            ++j;
+        unsigned long long digit = (e >> j) & ((1ULL << (i - j + 1)) - 1);
+        if (started)
+        {
+            for (int k = j; k <= i; ++k)
+                result = ctx.sqr(result);
+            result = ctx.mul(result, odd[digit >> 1]);
+        }
+        else
+        {
+            result = odd[digit >> 1];
+            started = true;
+        }
+        i = j - 1;
+    }
+    return (long long)ctx.from_mont(result);
+}
 
 //* Безопасное возведение в степень по модулю
 long long mod_pow(long long base, long long exp, long long mod)
 {
     if (mod <= 0)
         throw std::invalid_argument("mod_pow: mod must be > 0");
+
+    // Для нечётного модуля — арифметика Монтгомери (без 128-битного деления на каждом шаге);
+    // модули < 2^32 обходятся 64-битными произведениями
+    if ((mod & 1) && mod > 1 && exp > 0)
+    {
+        if (modint_width_for((unsigned long long)mod) == 32)
+        {
+            long long b = base % mod;
+            if (b < 0)
+                b += mod;
+            return (long long)mod_pow_width<32>((uint32_t)b, (unsigned long long)exp, (uint32_t)mod);
+        }
+        return mod_pow(base, exp, MontgomeryContext((unsigned long long)mod));
+    }
+
     long long result = 1 % mod;
     long long cur = base % mod;
     if (cur < 0)
@@ -38,301 +473,3189 @@ long long mod_pow(long long base, long long exp, long long mod)
 
     while (exp > 0)
     {
-        if (exp & 1)
+        if (exp & 1)
+        {
+            // используем 128-bit, чтобы избежать переполнения
+            __int128 t = (__int128)result * (__int128)cur;
+            result = (long long)(t % mod);
+        }
+        __int128 t2 = (__int128)cur * (__int128)cur;
+        cur = (long long)(t2 % mod);
+        exp >>= 1;
+    }
+    return result;
+}
+
+unsigned long long mod_pow_u64(unsigned long long base, unsigned long long exp, unsigned long long mod)
+{
+    if (mod == 0)
+        throw std::invalid_argument("mod_pow_u64: mod must be > 0");
+    if ((mod & 1) == 0 || mod == 1)
+    {
+        unsigned long long result;
+        mod_pow_batch(&base, exp, mod, &result, 1);
+        return result;
+    }
+    if (modint_width_for(mod) == 32)
+        return mod_pow_width<32>((uint32_t)(base % mod), exp, (uint32_t)mod);
+    return mod_pow_width<64>(base % mod, exp, mod);
+}
+
+//* Скалярная ветка пакетного возведения в степень (нечётный модуль, показатель перекодирован)
+static void pow_batch_recoded_scalar(const MontgomeryContext &ctx, const std::vector<ExpStep> &steps, int w,
+                                     const unsigned long long *bases, unsigned long long *out, size_t n)
+{
+    unsigned long long odd[1 << 7];
+    for (size_t i = 0; i < n; ++i)
+    {
+        odd_powers_mont(ctx, ctx.to_mont(bases[i]), w, odd);
+        out[i] = ctx.from_mont(pow_recoded_mont(ctx, odd, steps.data(), steps.size()));
+    }
+}
+
+//* Пакетное возведение для модулей без контекста Монтгомери (чётные или >= 2^63)
+static void mod_pow_batch_generic(const unsigned long long *bases, unsigned long long exp, unsigned long long mod,
+                                  unsigned long long *out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        unsigned long long result = 1 % mod;
+        unsigned long long cur = bases[i] % mod;
+        for (unsigned long long e = exp; e > 0; e >>= 1)
+        {
+            if (e & 1)
+                result = (unsigned long long)(((unsigned __int128)result * cur) % mod);
+            cur = (unsigned long long)(((unsigned __int128)cur * cur) % mod);
+        }
+        out[i] = result;
+    }
+}
+
+#ifdef CRYPTO_X86_SIMD
+// Монтгомери с R = 2^32 в 64-битных дорожках (значения < n < 2^31):
+// t = a*b, m = (t mod 2^32) * n' mod 2^32, res = (t + m*n) / 2^32, res < 2n
+__attribute__((target("avx2"))) static inline __m256i mont32_mul_avx2(__m256i a, __m256i b, __m256i n, __m256i n_neg)
+{
+    __m256i t = _mm256_mul_epu32(a, b);
+    __m256i m = _mm256_mul_epu32(t, n_neg);
+    __m256i u = _mm256_add_epi64(t, _mm256_mul_epu32(m, n));
+    __m256i res = _mm256_srli_epi64(u, 32);
+    return _mm256_min_epu32(res, _mm256_sub_epi32(res, n));
+}
+
+__attribute__((target("avx2"))) static void pow_batch_avx2(const MontgomeryContext &ctx, const std::vector<ExpStep> &steps, int w,
+                                                           const unsigned long long *bases, unsigned long long *out, size_t n)
+{
+    const unsigned long long mask32 = 0xFFFFFFFFULL;
+    unsigned long long r = (1ULL << 32) % ctx.n;
+    __m256i vn = _mm256_set1_epi64x((long long)ctx.n);
+    __m256i vneg = _mm256_set1_epi64x((long long)(ctx.n_neg & mask32));
+    __m256i vr = _mm256_set1_epi64x((long long)r);
+    __m256i vr2 = _mm256_set1_epi64x((long long)(r * r % ctx.n));
+    __m256i vone = _mm256_set1_epi64x(1);
+    __m256i odd[1 << 7];
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i b = _mm256_loadu_si256((const __m256i *)(bases + i));
+        odd[0] = mont32_mul_avx2(b, vr2, vn, vneg);
+        __m256i b2 = mont32_mul_avx2(odd[0], odd[0], vn, vneg);
+        for (int k = 1; k < (1 << (w - 1)); ++k)
+            odd[k] = mont32_mul_avx2(odd[k - 1], b2, vn, vneg);
+
+        __m256i result = steps.empty() ? vr : odd[steps[0].digit >> 1];
+        for (size_t s = 1; s < steps.size(); ++s)
+        {
+            for (int k = 0; k < steps[s].squarings; ++k)
+                result = mont32_mul_avx2(result, result, vn, vneg);
+            if (steps[s].digit)
+                result = mont32_mul_avx2(result, odd[steps[s].digit >> 1], vn, vneg);
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), mont32_mul_avx2(result, vone, vn, vneg));
+    }
+    if (i < n)
+        pow_batch_recoded_scalar(ctx, steps, w, bases + i, out + i, n - i);
+}
+
+// avx512fintrin.h в GCC 12 использует самоинициализацию (_mm512_undefined_*),
+// что даёт ложные -Wmaybe-uninitialized при встраивании
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f"))) static inline __m512i mont32_mul_avx512(__m512i a, __m512i b, __m512i n, __m512i n_neg)
+{
+    __m512i t = _mm512_mul_epu32(a, b);
+    __m512i m = _mm512_mul_epu32(t, n_neg);
+    __m512i u = _mm512_add_epi64(t, _mm512_mul_epu32(m, n));
+    __m512i res = _mm512_srli_epi64(u, 32);
+    return _mm512_min_epu32(res, _mm512_sub_epi32(res, n));
+}
+
+__attribute__((target("avx512f"))) static void pow_batch_avx512(const MontgomeryContext &ctx, const std::vector<ExpStep> &steps, int w,
+                                                                const unsigned long long *bases, unsigned long long *out, size_t n)
+{
+    const unsigned long long mask32 = 0xFFFFFFFFULL;
+    unsigned long long r = (1ULL << 32) % ctx.n;
+    __m512i vn = _mm512_set1_epi64((long long)ctx.n);
+    __m512i vneg = _mm512_set1_epi64((long long)(ctx.n_neg & mask32));
+    __m512i vr = _mm512_set1_epi64((long long)r);
+    __m512i vr2 = _mm512_set1_epi64((long long)(r * r % ctx.n));
+    __m512i vone = _mm512_set1_epi64(1);
+    __m512i odd[1 << 7];
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512i b = _mm512_loadu_si512((const void *)(bases + i));
+        odd[0] = mont32_mul_avx512(b, vr2, vn, vneg);
+        __m512i b2 = mont32_mul_avx512(odd[0], odd[0], vn, vneg);
+        for (int k = 1; k < (1 << (w - 1)); ++k)
+            odd[k] = mont32_mul_avx512(odd[k - 1], b2, vn, vneg);
+
+        __m512i result = steps.empty() ? vr : odd[steps[0].digit >> 1];
+        for (size_t s = 1; s < steps.size(); ++s)
+        {
+            for (int k = 0; k < steps[s].squarings; ++k)
+                result = mont32_mul_avx512(result, result, vn, vneg);
+            if (steps[s].digit)
+                result = mont32_mul_avx512(result, odd[steps[s].digit >> 1], vn, vneg);
+        }
+        _mm512_storeu_si512((void *)(out + i), mont32_mul_avx512(result, vone, vn, vneg));
+    }
+    if (i < n)
+        pow_batch_recoded_scalar(ctx, steps, w, bases + i, out + i, n - i);
+}
+
+// Монтгомери с R = 2^52 на IFMA (значения < n < 2^52):
+// произведение a*b раскладывается на младшие и старшие 52 бита без 64x64 умножения
+__attribute__((target("avx512f,avx512ifma"))) static inline __m512i mont52_mul_ifma(__m512i a, __m512i b, __m512i n, __m512i n_neg)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i t_lo = _mm512_madd52lo_epu64(zero, a, b);
+    __m512i t_hi = _mm512_madd52hi_epu64(zero, a, b);
+    __m512i m = _mm512_madd52lo_epu64(zero, t_lo, n_neg);
+    __m512i carry = _mm512_srli_epi64(_mm512_madd52lo_epu64(t_lo, m, n), 52);
+    __m512i res = _mm512_madd52hi_epu64(_mm512_add_epi64(t_hi, carry), m, n);
+    return _mm512_min_epu64(res, _mm512_sub_epi64(res, n));
+}
+
+__attribute__((target("avx512f,avx512ifma"))) static void pow_batch_ifma(const MontgomeryContext &ctx, const std::vector<ExpStep> &steps, int w,
+                                                                        const unsigned long long *bases, unsigned long long *out, size_t n)
+{
+    const unsigned long long mask52 = (1ULL << 52) - 1;
+    unsigned long long r = (1ULL << 52) % ctx.n;
+    __m512i vn = _mm512_set1_epi64((long long)ctx.n);
+    __m512i vneg = _mm512_set1_epi64((long long)(ctx.n_neg & mask52));
+    __m512i vr = _mm512_set1_epi64((long long)r);
+    __m512i vr2 = _mm512_set1_epi64((long long)((unsigned __int128)r * r % ctx.n));
+    __m512i vone = _mm512_set1_epi64(1);
+    __m512i odd[1 << 7];
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512i b = _mm512_loadu_si512((const void *)(bases + i));
+        odd[0] = mont52_mul_ifma(b, vr2, vn, vneg);
+        __m512i b2 = mont52_mul_ifma(odd[0], odd[0], vn, vneg);
+        for (int k = 1; k < (1 << (w - 1)); ++k)
+            odd[k] = mont52_mul_ifma(odd[k - 1], b2, vn, vneg);
+
+        __m512i result = steps.empty() ? vr : odd[steps[0].digit >> 1];
+        for (size_t s = 1; s < steps.size(); ++s)
+        {
+            for (int k = 0; k < steps[s].squarings; ++k)
+                result = mont52_mul_ifma(result, result, vn, vneg);
+            if (steps[s].digit)
+                result = mont52_mul_ifma(result, odd[steps[s].digit >> 1], vn, vneg);
+        }
+        _mm512_storeu_si512((void *)(out + i), mont52_mul_ifma(result, vone, vn, vneg));
+    }
+    if (i < n)
+        pow_batch_recoded_scalar(ctx, steps, w, bases + i, out + i, n - i);
+}
+#pragma GCC diagnostic pop
+#endif
+
+//* Пакетное возведение с готовым перекодированием: bases уже приведены по модулю ctx.n.
+//* Выбор SIMD-ядра по размеру модуля и возможностям CPU.
+static void pow_batch_recoded(const MontgomeryContext &ctx, const std::vector<ExpStep> &steps, int w,
+                              const unsigned long long *bases, unsigned long long *out, size_t n)
+{
+#ifdef CRYPTO_X86_SIMD
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    static const bool has_avx512 = __builtin_cpu_supports("avx512f");
+    static const bool has_ifma = has_avx512 && __builtin_cpu_supports("avx512ifma");
+
+    if (ctx.n < (1ULL << 31))
+    {
+        if (has_avx512)
+            return pow_batch_avx512(ctx, steps, w, bases, out, n);
+        if (has_avx2)
+            return pow_batch_avx2(ctx, steps, w, bases, out, n);
+    }
+    if (ctx.n < (1ULL << 52) && has_ifma)
+        return pow_batch_ifma(ctx, steps, w, bases, out, n);
+#endif
+    pow_batch_recoded_scalar(ctx, steps, w, bases, out, n);
+}
+
+void mod_pow_batch(const unsigned long long *bases, unsigned long long exp, unsigned long long mod,
+                   unsigned long long *out, size_t n)
+{
+    if (mod == 0)
+        throw std::invalid_argument("mod_pow_batch: mod must be > 0");
+    if (n == 0)
+        return;
+    if ((mod & 1) == 0 || mod == 1 || (mod >> 63))
+        return mod_pow_batch_generic(bases, exp, mod, out, n);
+
+    MontgomeryContext ctx(mod);
+    int w = sliding_window_width(bit_length(exp));
+    std::vector<ExpStep> steps = recode_sliding_window(exp, w);
+
+    // SIMD-ядра ожидают основания, уже приведённые по модулю
+    for (size_t i = 0; i < n; ++i)
+        out[i] = bases[i] < mod ? bases[i] : bases[i] % mod;
+    pow_batch_recoded(ctx, steps, w, out, out, n);
+}
+
+FixedExpPow::FixedExpPow(long long exp, long long mod, int window_bits)
+    : ctx((unsigned long long)mod), window(window_bits)
+{
+    if (exp < 0)
+        throw std::invalid_argument("FixedExpPow: exp must be >= 0");
+    if (window == 0)
+        window = sliding_window_width(bit_length((unsigned long long)exp));
+    if (window < 1 || window > 8)
+        throw std::invalid_argument("FixedExpPow: window_bits must be in [1, 8]");
+    steps = recode_sliding_window((unsigned long long)exp, window);
+}
+
+long long FixedExpPow::pow(long long base) const
+{
+    long long b = base % (long long)ctx.n;
+    if (b < 0)
+        b += (long long)ctx.n;
+    unsigned long long odd[1 << 7];
+    odd_powers_mont(ctx, ctx.to_mont((unsigned long long)b), window, odd);
+    return (long long)ctx.from_mont(pow_recoded_mont(ctx, odd, steps.data(), steps.size()));
+}
+
+void FixedExpPow::pow_batch(const unsigned long long *bases, unsigned long long *out, size_t n) const
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = bases[i] < ctx.n ? bases[i] : bases[i] % ctx.n;
+    pow_batch_recoded(ctx, steps, window, out, out, n);
+}
+
+//* Следующее скользящее окно показателя e не выше бита i: возвращает младший бит
+//* окна (или -1, если единичных бит не осталось) и нечётную цифру окна
+static int next_window(unsigned long long e, int i, int w, int &digit)
+{
+    if (i < 0)
+        return -1;
+    unsigned long long rest = i >= 63 ? e : e & ((2ULL << i) - 1);
+    if (rest == 0)
+        return -1;
+    int hi = bit_length(rest) - 1;
+    int lo = std::max(hi - w + 1, 0);
+    lo += __builtin_ctzll(rest >> lo);
+    digit = (int)((rest >> lo) & ((1ULL << (hi - lo + 1)) - 1));
+    return lo;
+}
+
+//* Произведение степеней по методу Штрауса: один общий ряд возведений в квадрат,
+//* у каждого слагаемого своё скользящее окно и своя таблица нечётных степеней
+long long multi_pow(const std::vector<std::pair<long long, long long>> &terms, long long mod)
+{
+    if (mod <= 0)
+        throw std::invalid_argument("multi_pow: mod must be > 0");
+    for (const auto &t : terms)
+        if (t.second < 0)
+            throw std::invalid_argument("multi_pow: exponents must be >= 0");
+
+    // Чётный модуль — Монтгомери неприменим, перемножаем обычные степени
+    if ((mod & 1) == 0 || mod == 1)
+    {
+        long long result = 1 % mod;
+        for (const auto &t : terms)
+            result = (long long)((__int128)result * mod_pow(t.first, t.second, mod) % mod);
+        return result;
+    }
+
+    MontgomeryContext ctx((unsigned long long)mod);
+
+    // Состояние слагаемого: ширина окна, текущее окно (младший бит, цифра), смещение таблицы
+    struct Term
+    {
+        unsigned long long e;
+        int w;
+        int pos;
+        int digit;
+        size_t odd;
+    };
+    // До 8 слагаемых состояние и таблицы умещаются на стеке
+    const size_t SMALL = 8;
+    Term st_small[SMALL];
+    unsigned long long odd_small[SMALL << 3];
+    std::vector<Term> st_big;
+    std::vector<unsigned long long> odd_big;
+    Term *st = st_small;
+    if (terms.size() > SMALL)
+    {
+        st_big.resize(terms.size());
+        st = st_big.data();
+    }
+    size_t table_size = 0;
+    int top = -1;
+    for (size_t t = 0; t < terms.size(); ++t)
+    {
+        Term &s = st[t];
+        s.e = (unsigned long long)terms[t].second;
+        int bits = bit_length(s.e);
+        s.w = sliding_window_width(bits);
+        s.pos = next_window(s.e, bits - 1, s.w, s.digit);
+        s.odd = table_size;
+        table_size += (size_t)1 << (s.w - 1);
+        top = std::max(top, bits - 1);
+    }
+    unsigned long long *odd = odd_small;
+    if (terms.size() > SMALL)
+    {
+        odd_big.resize(table_size);
+        odd = odd_big.data();
+    }
+    for (size_t t = 0; t < terms.size(); ++t)
+    {
+        long long b = terms[t].first % mod;
+        if (b < 0)
+            b += mod;
+        odd_powers_mont(ctx, ctx.to_mont((unsigned long long)b), st[t].w, &odd[st[t].odd]);
+    }
+
+    // Общий ряд квадратов идёт от окна к окну: до ближайшего (по всем слагаемым)
+    // младшего бита окна — квадраты, затем умножения всех слагаемых, чьё окно там
+    unsigned long long result = ctx.r;
+    bool started = false;
+    int at = top + 1;
+    while (true)
+    {
+        int next = -1;
+        for (size_t t = 0; t < terms.size(); ++t)
+            next = std::max(next, st[t].pos);
+        if (next < 0)
+            break;
+        if (started)
+            for (int k = next; k < at; ++k)
+                result = ctx.sqr(result);
+        at = next;
+        for (size_t t = 0; t < terms.size(); ++t)
+        {
+            Term &s = st[t];
+            if (s.pos != next)
+                continue;
+            unsigned long long f = odd[s.odd + (s.digit >> 1)];
+            result = started ? ctx.mul(result, f) : f;
+            started = true;
+            s.pos = next_window(s.e, next - 1, s.w, s.digit);
+        }
+    }
+    if (started)
+        for (int k = 0; k < at; ++k)
+            result = ctx.sqr(result);
+    return (long long)ctx.from_mont(result);
+}
+
+FixedBasePow::FixedBasePow(long long base, long long mod, int window_bits)
+    : ctx((unsigned long long)mod), window(window_bits)
+{
+    if (window < 1 || window > 16)
+        throw std::invalid_argument("FixedBasePow: window_bits must be in [1, 16]");
+
+    int mod_bits = 0;
+    for (unsigned long long t = ctx.n; t; t >>= 1)
+        ++mod_bits;
+    windows = (mod_bits + window - 1) / window;
+
+    long long b = base % mod;
+    if (b < 0)
+        b += mod;
+
+    const size_t row = (size_t)1 << window;
+    table.resize(row * windows);
+    unsigned long long g = ctx.to_mont((unsigned long long)b); // base^(2^(i*window))
+    for (int i = 0; i < windows; ++i)
+    {
+        unsigned long long *t = &table[i * row];
+        t[0] = ctx.r;
+        for (size_t j = 1; j < row; ++j)
+            t[j] = ctx.mul(t[j - 1], g);
+        g = ctx.mul(t[row - 1], g);
+    }
+    top = g;
+}
+
+long long FixedBasePow::pow(long long k) const
+{
+    if (k < 0)
+        throw std::invalid_argument("FixedBasePow::pow: k must be >= 0");
+
+    const unsigned long long mask = ((unsigned long long)1 << window) - 1;
+    const size_t row = (size_t)1 << window;
+    unsigned long long e = (unsigned long long)k;
+    unsigned long long result = ctx.r;
+    for (int i = 0; i < windows && e; ++i, e >>= window)
+    {
+        unsigned long long j = e & mask;
+        if (j)
+            result = ctx.mul(result, table[i * row + j]);
+    }
+
+    // Показатель длиннее таблицы: остаток обычной лестницей по top
+    for (unsigned long long cur = top; e; e >>= 1)
+    {
+        if (e & 1)
+            result = ctx.mul(result, cur);
+        cur = ctx.sqr(cur);
+    }
+    return (long long)ctx.from_mont(result);
+}
+
+//* Кэш таблиц фиксированного основания для часто повторяющихся пар (g, p)
+static std::shared_ptr<const FixedBasePow> cached_fixed_base(long long g, long long p)
+{
+    static std::mutex mtx;
+    static std::map<std::pair<long long, long long>, std::shared_ptr<const FixedBasePow>> cache;
+    const size_t MAX_ENTRIES = 64;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = cache.find({g, p});
+    if (it != cache.end())
+        return it->second;
+    if (cache.size() >= MAX_ENTRIES)
+        cache.clear();
+    auto table = std::make_shared<const FixedBasePow>(g, p, 4);
+    cache[{g, p}] = table;
+    return table;
+}
+
+//* Таблица нечётных простых меньше TRIAL_PRIME_LIMIT для пробного деления без делений.
+//* Для нечётного q: q | n  <=>  n * q^{-1} mod 2^64 <= (2^64 - 1) / q, где q^{-1} —
+//* обратный по модулю 2^64 (умножение на него — биекция, кратные q переходят в [0, (2^64-1)/q]).
+//* Таблица строится при компиляции и дополняется до кратного 8 фиктивными записями,
+//* которые ничего не делят (inv = 1, lim = 0: срабатывают только на n = 0)
+constexpr unsigned TRIAL_PRIME_LIMIT = 4096;
+
+constexpr bool is_small_odd_prime(unsigned n)
+{
+    for (unsigned j = 3; j * j <= n; j += 2)
+        if (n % j == 0)
+            return false;
+    return true;
+}
+
+constexpr int count_odd_primes_below(unsigned limit)
+{
+    int count = 0;
+    for (unsigned i = 3; i < limit; i += 2)
+        count += is_small_odd_prime(i);
+    return count;
+}
+
+constexpr int TRIAL_COUNT = count_odd_primes_below(TRIAL_PRIME_LIMIT);
+constexpr int TRIAL_PADDED = (TRIAL_COUNT + 7) / 8 * 8;
+
+struct alignas(64) TrialTable
+{
+    unsigned long long prime[TRIAL_PADDED];
+    unsigned long long inv[TRIAL_PADDED]; // q^{-1} mod 2^64
+    unsigned long long lim[TRIAL_PADDED]; // (2^64 - 1) / q
+};
+
+constexpr TrialTable make_trial_table()
+{
+    TrialTable t{};
+    int k = 0;
+    for (unsigned q = 3; q < TRIAL_PRIME_LIMIT; q += 2)
+    {
+        if (!is_small_odd_prime(q))
+            continue;
+        unsigned long long inv = q; // q * q ≡ 1 (mod 8), дальше Ньютон удваивает точность
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - q * inv;
+        t.prime[k] = q;
+        t.inv[k] = inv;
+        t.lim[k] = ~0ULL / q;
+        ++k;
+    }
+    for (; k < TRIAL_PADDED; ++k)
+    {
+        t.prime[k] = 1;
+        t.inv[k] = 1;
+        t.lim[k] = 0;
+    }
+    return t;
+}
+
+static constexpr TrialTable TRIAL = make_trial_table();
+
+//* Индекс первого простого таблицы с номером в [from, to), делящего n, или -1.
+//* from и to кратны 8 (границы блоков SIMD)
+static int trial_divisor_scalar(unsigned long long n, int from, int to)
+{
+    for (int i = from; i < to; ++i)
+        if (n * TRIAL.inv[i] <= TRIAL.lim[i])
+            return i;
+    return -1;
+}
+
+#ifdef CRYPTO_X86_SIMD
+// AVX2 не умеет 64-битное mullo и беззнаковое сравнение: младшее слово произведения
+// собирается из трёх 32x32 умножений, сравнение — знаковое после сдвига на 2^63
+__attribute__((target("avx2"))) static int trial_divisor_avx2(unsigned long long n, int from, int to)
+{
+    const __m256i vn = _mm256_set1_epi64x((long long)n);
+    const __m256i vn_hi = _mm256_set1_epi64x((long long)(n >> 32));
+    const __m256i sign = _mm256_set1_epi64x((long long)(1ULL << 63));
+    for (int i = from; i < to; i += 4)
+    {
+        __m256i inv = _mm256_load_si256((const __m256i *)(TRIAL.inv + i));
+        __m256i lim = _mm256_load_si256((const __m256i *)(TRIAL.lim + i));
+        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(vn, _mm256_srli_epi64(inv, 32)), _mm256_mul_epu32(vn_hi, inv));
+        __m256i prod = _mm256_add_epi64(_mm256_mul_epu32(vn, inv), _mm256_slli_epi64(cross, 32));
+        __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(prod, sign), _mm256_xor_si256(lim, sign));
+        int hit = ~_mm256_movemask_pd(_mm256_castsi256_pd(gt)) & 0xF;
+        if (hit)
+            return i + __builtin_ctz(hit);
+    }
+    return -1;
+}
+
+__attribute__((target("avx512f,avx512dq"))) static int trial_divisor_avx512(unsigned long long n, int from, int to)
+{
+    const __m512i vn = _mm512_set1_epi64((long long)n);
+    for (int i = from; i < to; i += 8)
+    {
+        __m512i prod = _mm512_mullo_epi64(vn, _mm512_load_si512(TRIAL.inv + i));
+        __mmask8 hit = _mm512_cmple_epu64_mask(prod, _mm512_load_si512(TRIAL.lim + i));
+        if (hit)
+            return i + __builtin_ctz(hit);
+    }
+    return -1;
+}
+#endif
+
+//* Первый делитель n среди простых таблицы с номерами [from, to): индекс или -1
+static int trial_divisor(unsigned long long n, int from = 0, int to = TRIAL_PADDED)
+{
+    from &= ~7;
+    to = std::min(TRIAL_PADDED, (to + 7) & ~7);
+#ifdef CRYPTO_X86_SIMD
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    static const bool has_avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+    if (has_avx512)
+        return trial_divisor_avx512(n, from, to);
+    if (has_avx2)
+        return trial_divisor_avx2(n, from, to);
+#endif
+    return trial_divisor_scalar(n, from, to);
+}
+
+//* Сильная проба Миллера-Рабина по основанию a: true — a свидетель составности n.
+//* Вся цепочка в форме Монтгомери; n - 1 = d * 2^s, возведения в квадрат — ctx.sqr
+static bool mr_witness(const MontgomeryContext &ctx, unsigned long long d, int s, unsigned long long a)
+{
+    a %= ctx.n;
+    if (a == 0)
+        return false;
+    const unsigned long long one = ctx.r;
+    const unsigned long long minus_one = ctx.n - ctx.r;
+    unsigned long long x = ctx.to_mont((unsigned long long)mod_pow((long long)a, (long long)d, ctx));
+    if (x == one || x == minus_one)
+        return false;
+    for (int r = 1; r < s; ++r)
+    {
+        x = ctx.sqr(x);
+        if (x == minus_one)
+            return false;
+        if (x == one)
+            return true;
+    }
+    return true;
+}
+
+// Наборы оснований Миллера-Рабина (Jaeschke, Sinclair): каждый точен ниже своей границы
+static const unsigned long long MR_BASES_32[] = {2, 7, 61};
+static const unsigned long long MR_BASES_40[] = {2, 13, 23, 1662803};
+static const unsigned long long MR_BASES_64[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+struct MrBaseSet
+{
+    const unsigned long long *bases;
+    int count;
+};
+static const MrBaseSet MR_BASE_SETS[] = {{MR_BASES_32, 3}, {MR_BASES_40, 4}, {MR_BASES_64, 7}};
+
+//* Номер минимального набора оснований, точного для n
+static int mr_base_set(unsigned long long n)
+{
+    if (n < 4759123141ULL)
+        return 0;
+    if (n < 1122004669633ULL)
+        return 1;
+    return 2;
+}
+
+//* Детерминированный Миллер-Рабин для нечётного 3 < n < 2^63 без пробного деления
+static bool miller_rabin(unsigned long long n)
+{
+    // представим n-1 = d * 2^s
+    unsigned long long d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+
+    const MrBaseSet &set = MR_BASE_SETS[mr_base_set(n)];
+    MontgomeryContext ctx(n);
+    for (int i = 0; i < set.count; ++i)
+        if (mr_witness(ctx, d, s, set.bases[i]))
+            return false;
+    return true;
+}
+
+#ifdef CRYPTO_X86_SIMD
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+//* Миллер-Рабин для 8 разных модулей сразу (дорожки AVX-512 IFMA, Монтгомери с R = 2^52):
+//* нечётные 61 < n[l] < 2^52 с общим набором оснований. Возвращает маску простых дорожек.
+//* Показатели d у дорожек разные: окно в 4 бита, степени основания a^0..a^15 лежат
+//* таблицей по дорожкам, множитель каждой дорожки выбирается gather по её цифре
+__attribute__((target("avx512f,avx512ifma"))) static unsigned mr_lanes_ifma(const unsigned long long *n, const MrBaseSet &set)
+{
+    const unsigned long long mask52 = (1ULL << 52) - 1;
+    alignas(64) unsigned long long d[8], neg[8], one[8], r2[8], s[8];
+    unsigned long long all_d = 0, max_s = 0;
+    for (int l = 0; l < 8; ++l)
+    {
+        unsigned long long inv = n[l];
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - n[l] * inv;
+        neg[l] = (0 - inv) & mask52;
+        s[l] = __builtin_ctzll(n[l] - 1);
+        d[l] = (n[l] - 1) >> s[l];
+        one[l] = (1ULL << 52) % n[l];
+        r2[l] = (unsigned long long)((unsigned __int128)one[l] * one[l] % n[l]);
+        all_d |= d[l];
+        max_s = std::max(max_s, s[l]);
+    }
+    const __m512i vn = _mm512_loadu_si512(n);
+    const __m512i vneg = _mm512_load_si512(neg);
+    const __m512i vone = _mm512_load_si512(one);
+    const __m512i vr2 = _mm512_load_si512(r2);
+    const __m512i vd = _mm512_load_si512(d);
+    const __m512i vs = _mm512_load_si512(s);
+    const __m512i vminus = _mm512_sub_epi64(vn, vone);
+
+    const __m512i lane = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const int digits = (bit_length(all_d) + 3) / 4;
+    alignas(64) unsigned long long table[16 * 8];
+
+    __mmask8 composite = 0;
+    for (int b = 0; b < set.count; ++b)
+    {
+        __m512i am = mont52_mul_ifma(_mm512_set1_epi64((long long)set.bases[b]), vr2, vn, vneg);
+        __m512i t = vone;
+        _mm512_store_si512(table, t);
+        for (int k = 1; k < 16; ++k)
+        {
+            t = mont52_mul_ifma(t, am, vn, vneg);
+            _mm512_store_si512(table + 8 * k, t);
+        }
+
+        __m512i x = vone;
+        for (int i = digits - 1; i >= 0; --i)
+        {
+            if (i != digits - 1)
+                for (int k = 0; k < 4; ++k)
+                    x = mont52_mul_ifma(x, x, vn, vneg);
+            __m512i digit = _mm512_and_si512(_mm512_srli_epi64(vd, 4 * i), _mm512_set1_epi64(15));
+            __m512i idx = _mm512_add_epi64(_mm512_slli_epi64(digit, 3), lane);
+            x = mont52_mul_ifma(x, _mm512_i64gather_epi64(idx, table, 8), vn, vneg);
+        }
+        __mmask8 pass = _mm512_cmpeq_epu64_mask(x, vone) | _mm512_cmpeq_epu64_mask(x, vminus);
+        for (unsigned long long r = 1; r < max_s; ++r)
+        {
+            x = mont52_mul_ifma(x, x, vn, vneg);
+            __mmask8 live = _mm512_cmpgt_epu64_mask(vs, _mm512_set1_epi64((long long)r));
+            pass |= live & _mm512_cmpeq_epu64_mask(x, vminus);
+        }
+        composite |= (__mmask8)~pass;
+    }
+    return (unsigned)(__mmask8)~composite;
+}
+#pragma GCC diagnostic pop
+#endif
+
+//* Миллер-Рабин для массива нечётных 61 < v[i] < 2^63 без пробного деления: числа
+//* меньше 2^52 группируются по набору оснований и идут по 8 в дорожки IFMA,
+//* остальные (и хвосты групп) — скалярно
+static void miller_rabin_batch(const unsigned long long *v, size_t n, bool *out)
+{
+#ifdef CRYPTO_X86_SIMD
+    static const bool has_ifma = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+    if (has_ifma)
+    {
+        alignas(64) unsigned long long lanes[3][8];
+        size_t where[3][8];
+        int fill[3] = {0, 0, 0};
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (v[i] >> 52)
+            {
+                out[i] = miller_rabin(v[i]);
+                continue;
+            }
+            int set = mr_base_set(v[i]);
+            lanes[set][fill[set]] = v[i];
+            where[set][fill[set]] = i;
+            if (++fill[set] == 8)
+            {
+                unsigned prime = mr_lanes_ifma(lanes[set], MR_BASE_SETS[set]);
+                for (int l = 0; l < 8; ++l)
+                    out[where[set][l]] = (prime >> l) & 1;
+                fill[set] = 0;
+            }
+        }
+        for (int set = 0; set < 3; ++set)
+            for (int l = 0; l < fill[set]; ++l)
+                out[where[set][l]] = miller_rabin(lanes[set][l]);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i)
+        out[i] = miller_rabin(v[i]);
+}
+
+//* Простота нечётного n > 1, у которого уже нет делителей среди простых таблицы
+//* с номерами меньше from: добиваем остаток таблицы, затем Миллер-Рабин
+static bool odd_prime_after_trial(unsigned long long n, int from)
+{
+    if (n < TRIAL_PRIME_LIMIT)
+    {
+        // делитель обязательно найдётся в таблице: n простое, если это оно само
+        int i = trial_divisor(n, from);
+        return i < 0 || TRIAL.prime[i] == n;
+    }
+    if (trial_divisor(n, from) >= 0)
+        return false;
+    // без делителей меньше TRIAL_PRIME_LIMIT и меньше его квадрата — простое
+    if (n < (unsigned long long)TRIAL_PRIME_LIMIT * TRIAL_PRIME_LIMIT)
+        return true;
+    return miller_rabin(n);
+}
+
+//* Тест простоты: пробное деление на простые до TRIAL_PRIME_LIMIT (векторное, без
+//* делений), затем детерминированный Миллер-Рабин с минимальным набором оснований
+//* для диапазона n — точный ответ для всех n < 2^63 (k сохранён для совместимости
+//* и не используется)
+bool is_probably_prime(long long n, int k)
+{
+    (void)k;
+    if (n < 2)
+        return false;
+    if (n % 2 == 0)
+        return n == 2;
+    return odd_prime_after_trial((unsigned long long)n, 0);
+}
+
+//* Нечётные простые до SIEVE_PRIME_LIMIT просеивают окна (начало таблицы TRIAL).
+//* Граница подобрана замером: для 64-битных чисел простые больше 256 выгоднее проверять
+//* у выживших кандидатов векторным ядром, чем вычислять для них смещение в окне
+static const unsigned SIEVE_PRIME_LIMIT = 256;
+static constexpr int SIEVE_PRIME_COUNT = count_odd_primes_below(SIEVE_PRIME_LIMIT);
+
+//* Решето на окне нечётных чисел start, start + 2, ..., start + 2*(len-1) (start нечётное):
+//* бит i в alive — у start + 2i нет делителей среди primes (нечётные простые по возрастанию;
+//* сами они не вычёркиваются: вычёркивание начинается с q^2)
+static void sieve_odd_window(unsigned long long start, size_t len, std::vector<unsigned long long> &alive,
+                             const unsigned long long *primes, size_t count)
+{
+    alive.assign((len + 63) / 64, ~0ULL);
+    if (len % 64)
+        alive.back() = (1ULL << (len % 64)) - 1;
+    unsigned long long last = start + 2 * (len - 1);
+    for (size_t k = 0; k < count; ++k)
+    {
+        unsigned long long q = primes[k];
+        unsigned long long qq = q * q;
+        if (qq > last)
+            break;
+        // первое нечётное кратное q, не меньшее max(start, q^2)
+        unsigned long long m = qq;
+        if (qq < start)
+        {
+            m = start + (q - start % q) % q;
+            if ((m & 1) == 0)
+                m += q;
+        }
+        for (unsigned long long i = (m - start) / 2; i < len; i += q)
+            alive[i >> 6] &= ~(1ULL << (i & 63));
+    }
+}
+
+//* Случайное простое из [low, high], равновероятное среди всех простых диапазона:
+//* берётся равномерно случайный нечётный кандидат, его окно из SIEVE_WINDOW нечётных
+//* просеивается простыми до SIEVE_PRIME_LIMIT, и принимается только сам кандидат, если
+//* он пережил решето и остаток таблицы TRIAL с Миллером-Рабином; иначе — новый кандидат.
+//* Решето последнего окна сохраняется: в узком диапазоне повторные попадания его не
+//* пересчитывают. Если простых долго нет, диапазон проверяется целиком — пустой
+//* диапазон даёт исключение
+static long long generate_prime_sieved(long long low, long long high)
+{
+    if (low < 2)
+        low = 2;
+    if (high < low)
+        std::swap(low, high);
+
+    // корректируем границы к нечётным и минимум 3
+    long long lo = (low % 2 == 0) ? low + 1 : low;
+    if (lo < 3)
+        lo = 3;
+    long long hi = (high % 2 == 0) ? high - 1 : high;
+    if (lo > hi)
+        throw std::runtime_error("generate_prime: no candidates");
+
+    // окно — несколько средних расстояний между простыми (~ln(n)/2 нечётных чисел)
+    const unsigned long long SIEVE_WINDOW = 64;
+    const unsigned long long count = (unsigned long long)(hi - lo) / 2 + 1;
+    const unsigned long long windows = (count + SIEVE_WINDOW - 1) / SIEVE_WINDOW;
+    auto window_start = [&](unsigned long long win) { return (unsigned long long)lo + 2 * win * SIEVE_WINDOW; };
+    auto window_len = [&](unsigned long long win) { return (size_t)std::min(SIEVE_WINDOW, count - win * SIEVE_WINDOW); };
+
+    std::uniform_int_distribution<unsigned long long> dist_idx(0, count - 1);
+    std::vector<unsigned long long> alive;
+    unsigned long long sieved = windows; // номер просеянного окна в alive; windows — нет
+    // в диапазоне без простых выборка не остановится: после стольких промахов подряд
+    // диапазон один раз проверяется целиком, и при отсутствии простых — исключение
+    const unsigned long long MAX_MISSES = std::min<unsigned long long>(16 * count + 64, 50000);
+    unsigned long long misses = 0;
+    bool range_checked = false;
+    while (true)
+    {
+        unsigned long long idx = dist_idx(crypto_rng());
+        unsigned long long win = idx / SIEVE_WINDOW;
+        if (win != sieved)
+        {
+            sieve_odd_window(window_start(win), window_len(win), alive, TRIAL.prime, SIEVE_PRIME_COUNT);
+            sieved = win;
+        }
+        size_t i = (size_t)(idx % SIEVE_WINDOW);
+        long long cand = (long long)(window_start(win) + 2ULL * i);
+        if ((alive[i >> 6] >> (i & 63) & 1) && odd_prime_after_trial((unsigned long long)cand, SIEVE_PRIME_COUNT))
+            return cand;
+
+        if (++misses < MAX_MISSES || range_checked)
+            continue;
+        bool any = false;
+        for (unsigned long long w = 0; w < windows && !any; ++w)
+        {
+            sieve_odd_window(window_start(w), window_len(w), alive, TRIAL.prime, SIEVE_PRIME_COUNT);
+            for (size_t k = 0; k < window_len(w) && !any; ++k)
+                any = (alive[k >> 6] >> (k & 63) & 1) &&
+                      odd_prime_after_trial(window_start(w) + 2ULL * k, SIEVE_PRIME_COUNT);
+        }
+        if (!any)
+            throw std::runtime_error("generate_prime: no prime found in range");
+        range_checked = true;
+        sieved = windows;
+    }
+}
+
+//* Число потоков по умолчанию — по числу ядер
+static unsigned long long hardware_threads()
+{
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+//* Запуск worker(t) для t = 0 .. nthreads-1; нулевой работает в вызывающем потоке
+template <class Worker>
+static void run_workers(unsigned long long nthreads, Worker &&worker)
+{
+    std::vector<std::thread> pool;
+    for (unsigned long long t = 1; t < nthreads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0ULL);
+    for (auto &th : pool)
+        th.join();
+}
+
+//* Совместное решето для безопасных простых на окне нечётных q = start + 2i:
+//* вычёркиваются q, у которых q или 2q + 1 делится на простое r < SIEVE_PRIME_LIMIT
+//* (само r не вычёркивается: кратные берутся начиная с 3r)
+static void sieve_safe_window(unsigned long long start, size_t len, std::vector<unsigned long long> &alive)
+{
+    alive.assign((len + 63) / 64, ~0ULL);
+    if (len % 64)
+        alive.back() = (1ULL << (len % 64)) - 1;
+    for (int k = 0; k < SIEVE_PRIME_COUNT; ++k)
+    {
+        unsigned long long r = TRIAL.prime[k];
+        // r | q  <=>  q ≡ 0 (mod r);  r | 2q + 1  <=>  q ≡ (r - 1) / 2 (mod r)
+        const unsigned long long residue[2] = {0, (r - 1) / 2};
+        const unsigned long long lower[2] = {3 * r, (3 * r - 1) / 2};
+        for (int t = 0; t < 2; ++t)
+        {
+            // первое нечётное q >= max(start, lower) с нужным остатком; шаг по окну — r
+            unsigned long long m = std::max(start, lower[t]);
+            m += (residue[t] + r - m % r) % r;
+            if ((m & 1) == 0)
+                m += r;
+            for (unsigned long long i = (m - start) / 2; i < len; i += r)
+                alive[i >> 6] &= ~(1ULL << (i & 63));
+        }
+    }
+}
+
+//* Безопасное простое: нечётные q из [q_low, q_high] делятся на окна по SAFE_WINDOW,
+//* окна совместно просеиваются по q и 2q + 1. Потоки берут окна через одно
+//* (поток t — окна first + t, first + t + threads, ...), выживших проверяют в случайном
+//* порядке; первый найденный результат останавливает остальные потоки
+static long long generate_safe_prime_sieved(long long q_low, long long q_high, int threads)
+{
+    if (q_high < q_low)
+        std::swap(q_low, q_high);
+    // p = 2q + 1 должно оставаться меньше 2^63
+    if (q_high > (LLONG_MAX - 1) / 2)
+        throw std::invalid_argument("generate_safe_prime: q_high is too large");
+
+    // q = 2 (p = 5) не рассматривается: дальше q только нечётные
+    long long lo = q_low < 3 ? 3 : (q_low % 2 == 0 ? q_low + 1 : q_low);
+    long long hi = (q_high % 2 == 0) ? q_high - 1 : q_high;
+    if (lo > hi)
+        throw std::runtime_error("generate_safe_prime: no candidates");
+
+    // безопасные простые в ~ln(q) раз реже простых — окно больше, чем в generate_prime
+    const unsigned long long SAFE_WINDOW = 1024;
+    unsigned long long count = (unsigned long long)(hi - lo) / 2 + 1;
+    unsigned long long windows = (count + SAFE_WINDOW - 1) / SAFE_WINDOW;
+    std::uniform_int_distribution<unsigned long long> dist_idx(0, count - 1);
+    unsigned long long first = dist_idx(crypto_rng()) / SAFE_WINDOW;
+
+    // автоматически — потоки только для длинных q: ниже 2^40 поиск в одном потоке
+    // занимает десятки микросекунд, меньше запуска потоков
+    unsigned long long nthreads = threads > 0 ? (unsigned long long)threads
+                                  : q_high >= (1LL << 40) ? hardware_threads()
+                                                          : 1;
+    nthreads = std::max(1ULL, std::min(nthreads, windows));
+    // зёрна потоков — из генератора вызывающего: поиск воспроизводим после random_seed
+    std::vector<unsigned long long> seeds(nthreads);
+    random_u64(seeds.data(), seeds.size());
+
+    std::atomic<bool> found{false};
+    long long result = 0; // пишет только поток, выигравший found; читается после join
+    auto worker = [&](unsigned long long t)
+    {
+        CryptoRng rng(seeds[t], t);
+        std::vector<unsigned long long> alive;
+        std::vector<unsigned> survivors;
+        for (unsigned long long w = t; w < windows; w += nthreads)
+        {
+            unsigned long long win = (first + w) % windows;
+            unsigned long long start = (unsigned long long)lo + 2 * win * SAFE_WINDOW;
+            size_t len = (size_t)std::min(SAFE_WINDOW, count - win * SAFE_WINDOW);
+            sieve_safe_window(start, len, alive);
+
+            survivors.clear();
+            for (size_t i = 0; i < alive.size(); ++i)
+                for (unsigned long long bits = alive[i]; bits; bits &= bits - 1)
+                    survivors.push_back((unsigned)(i * 64 + __builtin_ctzll(bits)));
+
+            while (!survivors.empty())
+            {
+                if (found.load(std::memory_order_relaxed))
+                    return;
+                std::uniform_int_distribution<size_t> pick(0, survivors.size() - 1);
+                size_t j = pick(rng);
+                unsigned long long q = start + 2ULL * survivors[j];
+                survivors[j] = survivors.back();
+                survivors.pop_back();
+                if (!odd_prime_after_trial(q, SIEVE_PRIME_COUNT) || !odd_prime_after_trial(2 * q + 1, SIEVE_PRIME_COUNT))
+                    continue;
+                bool expected = false;
+                if (found.compare_exchange_strong(expected, true))
+                    result = (long long)(2 * q + 1);
+                return;
+            }
+        }
+    };
+
+    run_workers(nthreads, worker);
+
+    if (!found)
+        throw std::runtime_error("generate_safe_prime: no safe prime found in range");
+    return result;
+}
+
+//* Проверка части массива в одном потоке: чётные и меньшие TRIAL_PRIME_LIMIT^2 решаются
+//* сразу, остальные после пробного деления собираются для пакетного Миллера-Рабина
+static void is_probably_prime_chunk(const long long *values, size_t n, bool *out)
+{
+    std::vector<unsigned long long> pending;
+    std::vector<size_t> where;
+    for (size_t i = 0; i < n; ++i)
+    {
+        long long x = values[i];
+        if (x < 2 || x % 2 == 0)
+            out[i] = x == 2;
+        else if ((unsigned long long)x < (unsigned long long)TRIAL_PRIME_LIMIT * TRIAL_PRIME_LIMIT)
+            out[i] = odd_prime_after_trial((unsigned long long)x, 0);
+        else if (trial_divisor((unsigned long long)x) >= 0)
+            out[i] = false;
+        else
+        {
+            pending.push_back((unsigned long long)x);
+            where.push_back(i);
+        }
+    }
+    std::unique_ptr<bool[]> prime(new bool[pending.size()]);
+    miller_rabin_batch(pending.data(), pending.size(), prime.get());
+    for (size_t k = 0; k < pending.size(); ++k)
+        out[where[k]] = prime[k];
+}
+
+void is_probably_prime_batch(const long long *values, size_t n, bool *out, int threads)
+{
+    // меньше PRIME_BATCH_PER_THREAD чисел на поток не выгодно: запуск потока дороже
+    const size_t PRIME_BATCH_PER_THREAD = 4096;
+    unsigned long long nthreads = threads > 0 ? (unsigned long long)threads : hardware_threads();
+    nthreads = std::max(1ULL, std::min<unsigned long long>(nthreads, n / PRIME_BATCH_PER_THREAD));
+    size_t chunk = (n + nthreads - 1) / nthreads;
+    auto worker = [&](unsigned long long t)
+    {
+        size_t from = std::min(n, (size_t)t * chunk);
+        size_t to = std::min(n, from + chunk);
+        is_probably_prime_chunk(values + from, to - from, out + from);
+    };
+    run_workers(nthreads, worker);
+}
+
+//* Сегментированное решето: нечётные числа [lo, hi] делятся на сегменты по PRIME_SEGMENT,
+//* сегменты раздаются потокам через общий счётчик. Просеивающие простые — до
+//* B = min(sqrt(hi), 2^20); выжившие меньше (B+1)^2 простые, остальные (только при
+//* hi > 2^40) проверяются пакетным Миллером-Рабином
+std::vector<long long> primes_in_range(long long lo, long long hi, int threads)
+{
+    if (hi < lo)
+        std::swap(lo, hi);
+    std::vector<long long> result;
+    if (hi < 2)
+        return result;
+    if (lo <= 2)
+    {
+        result.push_back(2);
+        lo = 3;
+    }
+    if (lo % 2 == 0)
+        ++lo;
+    if (lo > hi)
+        return result;
+
+    unsigned long long root = (unsigned long long)std::sqrt((long double)hi);
+    while (root * root > (unsigned long long)hi)
+        --root;
+    while ((root + 1) * (root + 1) <= (unsigned long long)hi)
+        ++root;
+    const unsigned long long bound = std::min(root, 1ULL << 20);
+    const unsigned long long exact = (bound + 1) * (bound + 1);
+
+    std::vector<unsigned long long> base;
+    {
+        std::vector<char> composite(bound + 1, 0);
+        for (unsigned long long i = 3; i <= bound; i += 2)
+        {
+            if (composite[i])
+                continue;
+            base.push_back(i);
+            for (unsigned long long j = i * i; j <= bound; j += 2 * i)
+                composite[j] = 1;
+        }
+    }
+
+    // 2^17 нечётных чисел — 16 КБ битовой маски, сегмент помещается в L1
+    const unsigned long long PRIME_SEGMENT = 1ULL << 17;
+    unsigned long long count = (unsigned long long)(hi - lo) / 2 + 1;
+    unsigned long long segments = (count + PRIME_SEGMENT - 1) / PRIME_SEGMENT;
+    std::vector<std::vector<long long>> parts(segments);
+    std::atomic<unsigned long long> next{0};
+
+    unsigned long long nthreads = threads > 0 ? (unsigned long long)threads : hardware_threads();
+    nthreads = std::max(1ULL, std::min(nthreads, segments));
+    auto worker = [&](unsigned long long)
+    {
+        std::vector<unsigned long long> alive, pending;
+        for (unsigned long long seg; (seg = next.fetch_add(1)) < segments;)
+        {
+            unsigned long long start = (unsigned long long)lo + 2 * seg * PRIME_SEGMENT;
+            size_t len = (size_t)std::min(PRIME_SEGMENT, count - seg * PRIME_SEGMENT);
+            sieve_odd_window(start, len, alive, base.data(), base.size());
+
+            // выжившие ниже exact идут раньше остальных — порядок сохраняется
+            std::vector<long long> &part = parts[seg];
+            pending.clear();
+            for (size_t i = 0; i < alive.size(); ++i)
+                for (unsigned long long bits = alive[i]; bits; bits &= bits - 1)
+                {
+                    unsigned long long x = start + 2 * (i * 64 + __builtin_ctzll(bits));
+                    if (x < exact)
+                        part.push_back((long long)x);
+                    else
+                        pending.push_back(x);
+                }
+            if (pending.empty())
+                continue;
+            std::unique_ptr<bool[]> prime(new bool[pending.size()]);
+            miller_rabin_batch(pending.data(), pending.size(), prime.get());
+            for (size_t k = 0; k < pending.size(); ++k)
+                if (prime[k])
+                    part.push_back((long long)pending[k]);
+        }
+    };
+    run_workers(nthreads, worker);
+
+    for (auto &part : parts)
+        result.insert(result.end(), part.begin(), part.end());
+    return result;
+}
+
+//* Генерация случайного простого числа в диапазоне low-high
+//* (сначала из пула CRYPTO_PRIME_POOL, если он задан)
+long long generate_prime(long long low, long long high)
+{
+    PrimePool *pool = PrimePool::from_env();
+    PrimePoolEntry entry;
+    if (pool && pool->take_in_range(std::min(low, high), std::max(low, high), false, entry))
+        return entry.p;
+    return generate_prime_sieved(low, high);
+}
+
+long long generate_safe_prime(long long q_low, long long q_high, int threads)
+{
+    // в пуле корзины по p = 2q + 1
+    PrimePool *pool = PrimePool::from_env();
+    PrimePoolEntry entry;
+    long long lo = std::min(q_low, q_high), hi = std::max(q_low, q_high);
+    if (pool && lo > 0 && hi <= (LLONG_MAX - 1) / 2 && pool->take_in_range(2 * lo + 1, 2 * hi + 1, true, entry))
+        return entry.p;
+    return generate_safe_prime_sieved(q_low, q_high, threads);
+}
+
+//* ---- Пул простых в файле ----
+// Файл (64-битные числа в порядке байт машины):
+//   заголовок PoolHeader (64 байта);
+//   корзины Bucket [safe][bits - POOL_MIN_BITS] по 64 байта — счётчики на отдельных кэш-линиях;
+//   записи [safe][bits - POOL_MIN_BITS][capacity] по 16 байт: p, g.
+// taken и filled только растут, запись с номером i лежит в слоте i % capacity.
+// take читает слот до CAS по taken: refill пишет в слот taken % capacity только после
+// того, как taken его прошёл, поэтому прочитанное до успешного CAS значение корректно.
+
+struct PrimePool::Bucket
+{
+    unsigned long long taken;  // выдано записей
+    unsigned long long filled; // записано записей (публикуется release после записи слота)
+    unsigned long long reserved[6];
+};
+
+struct PoolHeader
+{
+    char magic[8];
+    unsigned long long version;
+    unsigned long long capacity;
+    unsigned long long min_bits;
+    unsigned long long max_bits;
+    unsigned long long reserved[3];
+};
+
+static const char POOL_MAGIC[8] = {'P', 'R', 'I', 'M', 'P', 'O', 'O', 'L'};
+static const int POOL_BITS = PrimePool::POOL_MAX_BITS - PrimePool::POOL_MIN_BITS + 1;
+static const size_t POOL_BUCKET_SIZE = 64;
+static_assert(sizeof(PoolHeader) == 64, "pool header must fill one cache line");
+
+static size_t pool_file_size(unsigned long long capacity)
+{
+    return sizeof(PoolHeader) + 2 * POOL_BITS * (POOL_BUCKET_SIZE + 16 * capacity);
+}
+
+PrimePool::PrimePool(const std::string &path, size_t capacity) : lock_path(path + ".lock")
+{
+#ifdef _WIN32
+    (void)path;
+    (void)capacity;
+    throw std::runtime_error("PrimePool: memory-mapped pool is not supported on this platform");
+#else
+    // 0600: в файле лежат будущие секретные простые (P, Q RSA, p Эль-Гамаля)
+    fd = ::open(path.c_str(), capacity ? O_RDWR | O_CREAT : O_RDWR, 0600);
+    if (fd < 0)
+        throw std::runtime_error("PrimePool: cannot open " + path);
+
+    auto fail = [&](const std::string &msg)
+    {
+        if (base)
+            ::munmap(base, size);
+        ::flock(fd, LOCK_UN);
+        ::close(fd);
+        throw std::runtime_error("PrimePool: " + msg);
+    };
+    struct stat st;
+    PoolHeader header{};
+    auto read_header = [&]()
+    {
+        return ::fstat(fd, &st) == 0 && st.st_size != 0 &&
+               ::pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+               std::memcmp(header.magic, POOL_MAGIC, sizeof(POOL_MAGIC)) == 0 && header.version == 1 &&
+               header.min_bits == POOL_MIN_BITS && header.max_bits == POOL_MAX_BITS && header.capacity != 0 &&
+               (size_t)st.st_size == pool_file_size(header.capacity);
+    };
+
+    // готовый файл открывается без блокировки; flock на fd берёт только создающий процесс
+    // (от ftruncate до записи заголовка), refill блокирует отдельный файл path.lock
+    if (!read_header())
+    {
+        ::flock(fd, LOCK_EX);
+        if (::fstat(fd, &st) != 0)
+            fail("cannot stat " + path);
+        if (st.st_size == 0)
+        {
+            if (!capacity)
+                fail("pool file is empty: " + path);
+            header = PoolHeader{};
+            std::memcpy(header.magic, POOL_MAGIC, sizeof(POOL_MAGIC));
+            header.version = 1;
+            header.capacity = capacity;
+            header.min_bits = POOL_MIN_BITS;
+            header.max_bits = POOL_MAX_BITS;
+            if (::ftruncate(fd, (off_t)pool_file_size(capacity)) != 0 ||
+                ::pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+                fail("cannot create " + path);
+        }
+        // заголовок мог дописываться другим процессом — после его блокировки он полон
+        if (!read_header())
+            fail("bad pool file: " + path);
+        ::flock(fd, LOCK_UN);
+    }
+    size = (size_t)st.st_size;
+
+    void *map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        fail("cannot mmap " + path);
+    base = (unsigned char *)map;
+#endif
+}
+
+PrimePool::~PrimePool()
+{
+#ifndef _WIN32
+    if (base)
+        ::munmap(base, size);
+    if (fd >= 0)
+        ::close(fd);
+#endif
+}
+
+size_t PrimePool::capacity() const
+{
+    return (size_t)((const PoolHeader *)base)->capacity;
+}
+
+PrimePool::Bucket *PrimePool::bucket(int bits, bool safe) const
+{
+    static_assert(sizeof(Bucket) == POOL_BUCKET_SIZE, "pool bucket must fill one cache line");
+    Bucket *buckets = (Bucket *)(base + sizeof(PoolHeader));
+    return buckets + (safe ? POOL_BITS : 0) + (bits - POOL_MIN_BITS);
+}
+
+unsigned long long *PrimePool::slots(int bits, bool safe) const
+{
+    unsigned long long *entries = (unsigned long long *)(base + sizeof(PoolHeader) + 2 * POOL_BITS * sizeof(Bucket));
+    return entries + 2 * capacity() * ((safe ? POOL_BITS : 0) + (bits - POOL_MIN_BITS));
+}
+
+size_t PrimePool::available(int bits, bool safe) const
+{
+    if (bits < POOL_MIN_BITS || bits > POOL_MAX_BITS)
+        return 0;
+    Bucket *b = bucket(bits, safe);
+    unsigned long long taken = __atomic_load_n(&b->taken, __ATOMIC_ACQUIRE);
+    unsigned long long filled = __atomic_load_n(&b->filled, __ATOMIC_ACQUIRE);
+    return filled > taken ? (size_t)(filled - taken) : 0;
+}
+
+bool PrimePool::take(int bits, bool safe, PrimePoolEntry &out)
+{
+    if (bits < POOL_MIN_BITS || bits > POOL_MAX_BITS)
+        return false;
+    Bucket *b = bucket(bits, safe);
+    unsigned long long *slot = slots(bits, safe);
+    const unsigned long long cap = capacity();
+    unsigned long long t = __atomic_load_n(&b->taken, __ATOMIC_ACQUIRE);
+    while (t < __atomic_load_n(&b->filled, __ATOMIC_ACQUIRE))
+    {
+        unsigned long long *e = slot + 2 * (t % cap);
+        PrimePoolEntry got{(long long)__atomic_load_n(e, __ATOMIC_RELAXED), (long long)__atomic_load_n(e + 1, __ATOMIC_RELAXED)};
+        // при неудаче t получает текущее значение taken
+        if (!__atomic_compare_exchange_n(&b->taken, &t, t + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            continue;
+        // выданное простое стирается из файла. После CAS по taken refill уже может писать
+        // в этот слот следующую запись — стирание через CAS по самому слоту её не затрёт.
+        // g — открытая образующая, её не стираем
+        unsigned long long expected = (unsigned long long)got.p;
+        __atomic_compare_exchange_n(e, &expected, 0ULL, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        if (got.p != 0)
+        {
+            out = got;
+            return true;
+        }
+        // 0 — запись стёрта: refill записал то же простое до стирания прежней выдачи
+        t = __atomic_load_n(&b->taken, __ATOMIC_ACQUIRE);
+    }
+    return false;
+}
+
+bool PrimePool::take_in_range(long long lo, long long hi, bool safe, PrimePoolEntry &out)
+{
+    if (hi < lo)
+        std::swap(lo, hi);
+    int bits[POOL_BITS];
+    int count = 0;
+    unsigned long long total = 0;
+    for (int b = POOL_MIN_BITS; b <= POOL_MAX_BITS; ++b)
+        if ((1LL << (b - 1)) >= lo && (1LL << b) - 1 <= hi && available(b, safe))
+        {
+            bits[count++] = b;
+            total += 1ULL << (b - 1);
+        }
+
+    while (count > 0)
+    {
+        unsigned long long r = std::uniform_int_distribution<unsigned long long>(0, total - 1)(crypto_rng());
+        int k = 0;
+        while (r >= (1ULL << (bits[k] - 1)))
+            r -= 1ULL << (bits[k++] - 1);
+        if (take(bits[k], safe, out))
+            return true;
+        // корзину опустошили другие процессы — выбираем среди оставшихся
+        total -= 1ULL << (bits[k] - 1);
+        bits[k] = bits[--count];
+    }
+    return false;
+}
+
+//* Наименьшая образующая группы по модулю безопасного простого p = 2q + 1:
+//* порядок g — делитель 2q, поэтому достаточно g^2 != 1 и g^q != 1
+static long long safe_prime_generator(long long p)
+{
+    long long q = (p - 1) / 2;
+    for (long long g = 2; g < p - 1; ++g)
+        if (mod_pow(g, q, p) != 1)
+            return g;
+    return -1;
+}
+
+size_t PrimePool::refill(int min_bits, int max_bits)
+{
+    min_bits = std::max(min_bits, (int)POOL_MIN_BITS);
+    max_bits = std::min(max_bits, (int)POOL_MAX_BITS);
+    const unsigned long long cap = capacity();
+    size_t added = 0;
+
+#ifndef _WIN32
+    // один пополняющий за раз (процесс или поток — у каждого вызова свой дескриптор);
+    // блокируется отдельный файл, поэтому открытие пула и take пополнения не ждут
+    int lock_fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (lock_fd < 0)
+        throw std::runtime_error("PrimePool: cannot open " + lock_path);
+    ::flock(lock_fd, LOCK_EX);
+#endif
+    try
+    {
+        for (int safe = 0; safe < 2; ++safe)
+            for (int bits = min_bits; bits <= max_bits; ++bits)
+            {
+                Bucket *b = bucket(bits, safe);
+                unsigned long long *slot = slots(bits, safe);
+                unsigned long long f = __atomic_load_n(&b->filled, __ATOMIC_RELAXED);
+                while (f - __atomic_load_n(&b->taken, __ATOMIC_ACQUIRE) < cap)
+                {
+                    long long p, g = 0;
+                    if (safe)
+                    {
+                        // p из [2^(bits-1), 2^bits): q = (p - 1) / 2 на бит короче
+                        p = generate_safe_prime_sieved(1LL << (bits - 2), (1LL << (bits - 1)) - 1, 1);
+                        g = safe_prime_generator(p);
+                    }
+                    else
+                        p = generate_prime_sieved(1LL << (bits - 1), (1LL << bits) - 1);
+                    unsigned long long *e = slot + 2 * (f % cap);
+                    __atomic_store_n(e, (unsigned long long)p, __ATOMIC_RELAXED);
+                    __atomic_store_n(e + 1, (unsigned long long)g, __ATOMIC_RELAXED);
+                    __atomic_store_n(&b->filled, ++f, __ATOMIC_RELEASE);
+                    ++added;
+                }
+            }
+    }
+    catch (...)
+    {
+#ifndef _WIN32
+        ::close(lock_fd);
+#endif
+        throw;
+    }
+#ifndef _WIN32
+    ::close(lock_fd); // закрытие снимает flock
+#endif
+    return added;
+}
+
+PrimePool *PrimePool::from_env()
+{
+    static const std::unique_ptr<PrimePool> pool = []() -> std::unique_ptr<PrimePool>
+    {
+        const char *path = std::getenv("CRYPTO_PRIME_POOL");
+        if (!path || !*path)
+            return nullptr;
+        // пул необязателен: без него числа генерируются как обычно
+        try
+        {
+            return std::unique_ptr<PrimePool>(new PrimePool(path));
+        }
+        catch (const std::exception &)
+        {
+            return nullptr;
+        }
+    }();
+    return pool.get();
+}
+
+//* Детерминированный Миллер-Рабин для любого n < 2^64: ниже 2^63 — is_probably_prime,
+//* выше — те же основания MR_BASES_64 на ModInt-параметрах с R = 2^64
+static bool is_prime_u64(unsigned long long n)
+{
+    if (n < (1ULL << 63))
+        return is_probably_prime((long long)n, 0);
+    if ((n & 1) == 0 || trial_divisor(n) >= 0)
+        return false;
+
+    const MontgomeryParams<64> mp(n);
+    unsigned long long d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+    const unsigned long long minus_one = n - mp.r;
+    for (unsigned long long a : MR_BASES_64)
+    {
+        a %= n;
+        if (a == 0)
+            continue;
+        unsigned long long x = mp.r, cur = mp.to_mont(a);
+        for (unsigned long long e = d; e; e >>= 1)
+        {
+            if (e & 1)
+                x = mp.mul(x, cur);
+            cur = mp.mul(cur, cur);
+        }
+        if (x == mp.r || x == minus_one)
+            continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; ++r)
+        {
+            x = mp.mul(x, x);
+            if (x == minus_one)
+                composite = false;
+            else if (x == mp.r)
+                break;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
+
+//* Нетривиальный делитель нечётного составного n (ро-метод Полларда в варианте Брента).
+//* Итерация f(y) = y^2 + c в форме Монтгомери; разности копятся произведением
+//* по BATCH шагов, поэтому gcd считается один раз на блок. Если блок дал gcd = n,
+//* его шаги повторяются по одному; если и это не помогло — берётся следующее c
+static unsigned long long pollard_brent(unsigned long long n)
+{
+    const MontgomeryParams<64> mp(n);
+    const unsigned long long BATCH = 128;
+    for (unsigned long long c = 1;; ++c)
+    {
+        const unsigned long long cm = mp.to_mont(c);
+        auto f = [&](unsigned long long v) { return mp.add(mp.mul(v, v), cm); };
+        auto diff = [](unsigned long long a, unsigned long long b) { return a > b ? a - b : b - a; };
+
+        unsigned long long x = 0, y = mp.to_mont(2), ys = y, q = mp.r, g = 1;
+        for (unsigned long long r = 1; g == 1; r <<= 1)
+        {
+            x = y;
+            for (unsigned long long i = 0; i < r; ++i)
+                y = f(y);
+            for (unsigned long long k = 0; k < r && g == 1; k += BATCH)
+            {
+                ys = y;
+                for (unsigned long long i = 0; i < std::min(BATCH, r - k); ++i)
+                {
+                    y = f(y);
+                    q = mp.mul(q, diff(x, y));
+                }
+                g = std::gcd(q, n);
+            }
+        }
+        if (g == n)
+        {
+            do
+            {
+                ys = f(ys);
+                g = std::gcd(diff(x, ys), n);
+            } while (g == 1);
+        }
+        if (g != n)
+            return g;
+    }
+}
+
+std::vector<std::pair<unsigned long long, int>> factor(unsigned long long n)
+{
+    if (n == 0)
+        throw std::invalid_argument("factor: n must be > 0");
+
+    std::vector<unsigned long long> primes;
+    // двойка и простые таблицы TRIAL — векторным ядром; найденный множитель
+    // снимается точным делением (умножением на обратный по модулю 2^64)
+    if ((n & 1) == 0)
+    {
+        int twos = __builtin_ctzll(n);
+        primes.insert(primes.end(), twos, 2);
+        n >>= twos;
+    }
+    for (int i = trial_divisor(n); i >= 0; i = trial_divisor(n, i + 1))
+        while (n * TRIAL.inv[i] <= TRIAL.lim[i])
+        {
+            primes.push_back(TRIAL.prime[i]);
+            n *= TRIAL.inv[i];
+        }
+
+    // у остатка все делители больше TRIAL_PRIME_LIMIT: меньше его квадрата — простое
+    const unsigned long long TRIAL_SQUARE = (unsigned long long)TRIAL_PRIME_LIMIT * TRIAL_PRIME_LIMIT;
+    std::vector<unsigned long long> stack;
+    if (n > 1)
+        stack.push_back(n);
+    while (!stack.empty())
+    {
+        unsigned long long m = stack.back();
+        stack.pop_back();
+        if (m < TRIAL_SQUARE || is_prime_u64(m))
+        {
+            primes.push_back(m);
+            continue;
+        }
+        unsigned long long d = pollard_brent(m);
+        stack.push_back(d);
+        stack.push_back(m / d);
+    }
+
+    std::sort(primes.begin(), primes.end());
+    std::vector<std::pair<unsigned long long, int>> result;
+    for (unsigned long long q : primes)
+        if (!result.empty() && result.back().first == q)
+            ++result.back().second;
+        else
+            result.push_back({q, 1});
+    return result;
+}
+
+//* Разложение p - 1 с кэшем на процесс (ключ — p): повторные find_generator
+//* и bsgs_generate_random_params для того же p не раскладывают заново
+static std::shared_ptr<const std::vector<std::pair<unsigned long long, int>>> cached_factor_phi(long long p)
+{
+    static std::mutex mtx;
+    static std::unordered_map<long long, std::shared_ptr<const std::vector<std::pair<unsigned long long, int>>>> cache;
+    const size_t MAX_ENTRIES = 1024;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = cache.find(p);
+        if (it != cache.end())
+            return it->second;
+    }
+    // разложение — вне блокировки, чтобы не задерживать другие потоки
+    auto factors = std::make_shared<const std::vector<std::pair<unsigned long long, int>>>(factor((unsigned long long)p - 1));
+    std::lock_guard<std::mutex> lock(mtx);
+    if (cache.size() >= MAX_ENTRIES)
+        cache.clear();
+    cache[p] = factors;
+    return factors;
+}
+
+long long find_generator(long long p)
+{
+    if (p <= 2)
+        return -1; // для p<=2 нет смысла
+
+    // Опционально: требуем, чтобы p было простым (для простой и корректной работы)
+    if (!is_probably_prime(p, 5))
+        return -1;
+
+    // 1. Простые множители phi = p-1 (из кэша или factor)
+    long long phi = p - 1;
+    auto factors = cached_factor_phi(p);
+
+    // 2. Перебор кандидатов g
+    for (long long g = 2; g < p; g++)
+    {
+        bool ok = true;
+        for (const auto &f : *factors)
+        {
+            if (mod_pow(g, phi / (long long)f.first, p) == 1)
+            {
+                ok = false;
+                break;
+            }
+        }
+        if (ok)
+            return g; // найден генератор
+    }
+
+    return -1; // если не нашли
+}
+
+std::tuple<long long, long long, long long> egcd(long long a, long long b)
+{
+    if (a <= 0 || b < 0)
+    {
+        throw std::invalid_argument(
+            "extended_gcd: expected positive a and non-negative b");
+    }
+
+    long long u1 = a, u2 = 1, u3 = 0; // U = (u1, u2, u3) = (a, 1, 0)
+    long long v1 = b, v2 = 0, v3 = 1; // V = (v1, v2, v3) = (b, 0, 1)
+
+    while (v1 != 0)
+    {
+        long long q = u1 / v1;
+        // T = (u1 mod v1, u2 - q*v2, u3 - q*v3)
+        long long t1 = u1 % v1;
+        long long t2 = u2 - q * v2;
+        long long t3 = u3 - q * v3;
+
+        // Сдвигаем: U = V, V = T
+        u1 = v1;
+        u2 = v2;
+        u3 = v3;
+        v1 = t1;
+        v2 = t2;
+        v3 = t3;
+    }
+
+    // Теперь U = (gcd, x, y)
+    return {u1, u2, u3};
+}
+
+//* Обратный элемент по модулю m (0 < a < m): алгоритм Евклида только с коэффициентом
+//* при a — вдвое меньше работы, чем в egcd. Бинарный вариант (сдвиги вместо деления)
+//* на 64-битных словах проигрывает аппаратному делению из-за непредсказуемых ветвлений.
+//* Возвращает 0, если обратного нет
+static unsigned long long inverse_euclid(unsigned long long a, unsigned long long m)
+{
+    unsigned long long u = a, v = m;
+    long long x0 = 1, x1 = 0; // a * x0 ≡ u, a * x1 ≡ v (mod m); |x| <= m / 2
+    while (v != 0)
+    {
+        unsigned long long q = u / v;
+        unsigned long long t = u - q * v;
+        u = v;
+        v = t;
+        long long tx = x0 - (long long)q * x1;
+        x0 = x1;
+        x1 = tx;
+    }
+    if (u != 1)
+        return 0;
+    return x0 < 0 ? (unsigned long long)(x0 + (long long)m) : (unsigned long long)x0;
+}
+
+long long mod_inverse(long long a, long long m)
+{
+    if (m <= 0)
+        throw std::invalid_argument("mod_inverse: m must be > 0");
+    if (m == 1)
+        return 0;
+    a %= m;
+    if (a < 0)
+        a += m;
+    if (a == 0)
+        return -1;
+    unsigned long long x = inverse_euclid((unsigned long long)a, (unsigned long long)m);
+    return x ? (long long)x : -1;
+}
+
+//* Трюк Монтгомери: префиксные произведения, одно обращение и обратный проход.
+//* Префиксы считаются умножением Монтгомери без перевода в форму Монтгомери:
+//* pre[i] = a0*...*ai * R^{-i}, а обратный к pre[n-1] равен P^{-1} * R^{n-1} —
+//* множители R сокращаются на обратном проходе, итого 3(n-1) умножений
+void batch_inverse(unsigned long long *values, size_t n, unsigned long long p)
+{
+    if (n == 0)
+        return;
+    if ((p & 1) == 0 || p < 3 || p >> 63)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            long long x = mod_inverse((long long)(values[i] % p), (long long)p);
+            if (x < 0)
+                throw std::runtime_error("batch_inverse: value is not invertible");
+            values[i] = (unsigned long long)x;
+        }
+        return;
+    }
+
+    MontgomeryContext ctx(p);
+    std::vector<unsigned long long> pre(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        unsigned long long a = values[i] < p ? values[i] : values[i] % p;
+        values[i] = a;
+        pre[i] = i ? ctx.mul(pre[i - 1], a) : a;
+    }
+    unsigned long long inv = pre[n - 1] ? inverse_euclid(pre[n - 1], p) : 0;
+    if (inv == 0)
+        throw std::runtime_error("batch_inverse: value is not invertible");
+
+    for (size_t i = n - 1; i > 0; --i)
+    {
+        unsigned long long a = values[i];
+        values[i] = ctx.mul(inv, pre[i - 1]);
+        inv = ctx.mul(inv, a);
+    }
+    values[0] = inv;
+}
+
+//* Случайная пара чисел (a, b) с условием min_a <= b <= a <= max_a
+std::pair<long long, long long> API egcd_generate_random_pair(long long min_a, long long max_a)
+{
+    if (min_a < 1)
+        min_a = 1;
+    if (max_a <= min_a)
+        max_a = min_a + 1;
+
+    long long a = random_range(min_a, max_a);
+    long long b = random_range(min_a, a);
+
+    return {a, b};
+}
+
+//* Генерация пары простых чисел в диапазоне [min_a, max_a]
+std::pair<long long, long long> API egcd_generate_prime_pair(long long min_a, long long max_a)
+{
+    if (min_a < 2)
+        min_a = 2;
+    if (max_a <= min_a)
+        max_a = min_a + 1000;
+
+    long long a = generate_prime(min_a, max_a);
+
+    long long b;
+    do
+    {
+        b = generate_prime(min_a, max_a);
+    } while (b == a);
+
+    return {a, b};
+}
+
+//* Таблица шагов младенца: открытая адресация с линейным пробированием.
+//* Запись — одно 64-битное слово: 32-битный отпечаток ключа в старшей половине
+//* и номер шага j в младшей; 0 — пустой слот (нулевой отпечаток заменяется единицей).
+//* Отпечаток усечён, поэтому совпадение — лишь кандидат, его проверяет вызывающий.
+//* Слот и отпечаток берутся из разных бит мультипликативного хэша ключа.
+//* Память берётся mmap (страницы уже обнулены); huge_pages — сначала MAP_HUGETLB,
+//* при неудаче обычные страницы с подсказкой MADV_HUGEPAGE.
+//* Таблица может лежать и внутри отображённого файла (см. DlogTable): тогда она
+//* только для чтения и владеет всем отображением
+class BabyStepTable
+{
+public:
+    //* Наименьшая ёмкость (степень двойки) для n записей при заполнении не больше половины
+    static size_t capacity_for(size_t n)
+    {
+        size_t cap = 16;
+        while (cap < 2 * n)
+            cap <<= 1;
+        return cap;
+    }
+
+#if !defined(_WIN32) && defined(MAP_HUGETLB)
+    //* Размер огромной страницы по умолчанию (Hugepagesize из /proc/meminfo), 0 — неизвестен
+    static size_t huge_page_size()
+    {
+        static const size_t size = []() -> size_t
+        {
+            std::ifstream meminfo("/proc/meminfo");
+            std::string key;
+            size_t kb;
+            while (meminfo >> key)
+            {
+                if (key == "Hugepagesize:" && meminfo >> kb)
+                    return kb * 1024;
+                meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            return 0;
+        }();
+        return size;
+    }
+#endif
+
+    explicit BabyStepTable(size_t n, bool huge_pages = false)
+    {
+        init(capacity_for(n));
+        map_bytes = capacity() * sizeof(unsigned long long);
+#ifndef _WIN32
+        void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        // ядро округляет MAP_HUGETLB до размера страницы, и munmap требует ту же длину:
+        // таблица меньше страницы берёт обычные страницы, иначе длина округляется
+        const size_t huge = huge_pages ? huge_page_size() : 0;
+        if (huge && map_bytes >= huge)
+        {
+            size_t rounded = (map_bytes + huge - 1) / huge * huge;
+            mem = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mem != MAP_FAILED)
+                map_bytes = rounded;
+        }
+#endif
+        if (mem == MAP_FAILED)
+        {
+            mem = ::mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED)
+                throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            if (huge_pages)
+                ::madvise(mem, map_bytes, MADV_HUGEPAGE);
+#endif
+        }
+        mapping = mem;
+        slots = (unsigned long long *)mem;
+#else
+        (void)huge_pages;
+        slots = new unsigned long long[capacity()]();
+#endif
+    }
+    //* Таблица из capacity слотов по адресу table внутри отображения mapping (map_bytes байт)
+    BabyStepTable(void *mapping, size_t map_bytes, unsigned long long *table, size_t capacity)
+        : slots(table), mapping(mapping), map_bytes(map_bytes)
+    {
+        init(capacity);
+    }
+    ~BabyStepTable()
+    {
+#ifndef _WIN32
+        ::munmap(mapping, map_bytes);
+#else
+        delete[] slots;
+#endif
+    }
+    BabyStepTable(const BabyStepTable &) = delete;
+    BabyStepTable &operator=(const BabyStepTable &) = delete;
+
+    size_t capacity() const { return mask + 1; }
+    const unsigned long long *data() const { return slots; }
+
+    void insert(unsigned long long key, uint32_t index)
+    {
+        unsigned long long h = hash(key);
+        size_t i = (size_t)(h >> shift);
+        while (slots[i])
+            i = (i + 1) & mask;
+        slots[i] = (unsigned long long)fingerprint(h) << 32 | index;
+    }
+
+    //* Вызывает on_match(j) для каждой записи с отпечатком key, пока тот не вернёт true
+    template <class F>
+    bool find(unsigned long long key, F &&on_match) const
+    {
+        unsigned long long h = hash(key);
+        const uint32_t fp = fingerprint(h);
+        for (size_t i = (size_t)(h >> shift); slots[i]; i = (i + 1) & mask)
+            if ((uint32_t)(slots[i] >> 32) == fp && on_match((uint32_t)slots[i]))
+                return true;
+        return false;
+    }
+
+    //* Подгрузка в кэш первого слота key (перед find для нескольких независимых ключей)
+    void prefetch(unsigned long long key) const
+    {
+        __builtin_prefetch(slots + (size_t)(hash(key) >> shift));
+    }
+
+private:
+    void init(size_t cap)
+    {
+        mask = cap - 1;
+        shift = 64 - __builtin_ctzll((unsigned long long)cap);
+    }
+    static unsigned long long hash(unsigned long long key) { return key * 0x9E3779B97F4A7C15ULL; }
+    static uint32_t fingerprint(unsigned long long h) { return (uint32_t)h ? (uint32_t)h : 1; }
+
+    unsigned long long *slots = nullptr;
+    void *mapping = nullptr;
+    size_t map_bytes = 0;
+    size_t mask = 0;
+    int shift = 0;
+};
+
+//* BSGS с m шагами младенца и order / m + 1 шагами великана (order — граница порядка a).
+//* Шаги младенца y * a^j и великана (a^m)^i — последовательными умножениями в форме
+//* Монтгомери (для чётного p — обычными с 128-битным произведением); на каждый шаг
+//* великана один поиск в таблице. Совпадение отпечатка проверяется: a^x == y (mod p)
+static long long bsgs_steps(long long a, long long y, long long p, long long order, long long m, bool huge_pages)
+{
+    if (p < 2)
+        return -1;
+    const long long target = ((y % p) + p) % p;
+    a = ((a % p) + p) % p;
+
+    std::unique_ptr<MontgomeryContext> ctx;
+    if (p & 1)
+        ctx.reset(new MontgomeryContext((unsigned long long)p));
+    auto mul = [&](unsigned long long u, unsigned long long v)
+    {
+        return ctx ? ctx->mul(u, v) : (unsigned long long)((unsigned __int128)u * v % (unsigned long long)p);
+    };
+    auto to_form = [&](unsigned long long u) { return ctx ? ctx->to_mont(u) : u; };
+
+    BabyStepTable baby_steps((size_t)m, huge_pages);
+
+    // Шаги младенца: y * a^j. Если a^j вернулось к 1, j — порядок a: дальше значения
+    // повторяются (повторы удлиняли бы цепочки в таблице до O(m^2) на построение),
+    // а одного шага великана a^j = 1 хватает на все x
+    const unsigned long long a_f = to_form((unsigned long long)a);
+    const unsigned long long one = to_form(1 % (unsigned long long)p);
+    unsigned long long value = to_form((unsigned long long)target), a_pow = one;
+    long long period = 0;
+    for (long long j = 0; j < m; j++)
+    {
+        baby_steps.insert(value, (uint32_t)j);
+        value = mul(value, a_f);
+        a_pow = mul(a_pow, a_f);
+        if (a_pow == one)
+        {
+            period = j + 1;
+            m = period;
+            break;
+        }
+    }
+
+    const unsigned long long a_m = to_form((unsigned long long)mod_pow(a, m, p));
+
+    // Шаги великана: (a^m)^i, пока i * m не покроет все x < order
+    const long long giant = period ? 1 : order / m + 1;
+    unsigned long long gamma = to_form(1 % (unsigned long long)p);
+    long long i = 0, x = -1;
+    auto verify = [&](uint32_t j)
+    {
+        long long cand = i * m - (long long)j;
+        if (cand < 0 || mod_pow(a, cand, p) != target)
+            return false;
+        x = cand;
+        return true;
+    };
+    for (; i <= giant; i++)
+    {
+        if (baby_steps.find(gamma, verify))
+            return x % (period ? period : p - 1);
+        gamma = mul(gamma, a_m);
+    }
+
+    return -1; // решение не найдено
+}
+
+//* Порядок a в мультипликативной группе по модулю простого p (делитель p - 1):
+//* из p - 1 снимаются простые множители, пока a^(n/q) == 1
+static long long element_order(long long a, long long p)
+{
+    long long n = p - 1;
+    for (const auto &f : *cached_factor_phi(p))
+        for (int e = 0; e < f.second && mod_pow(a, n / (long long)f.first, p) == 1; ++e)
+            n /= (long long)f.first;
+    return n;
+}
+
+//* Простые множители порядка n элемента по модулю p (n | p - 1) из кэшированного разложения p - 1
+static std::vector<std::pair<unsigned long long, int>> order_factors(long long n, long long p)
+{
+    std::vector<std::pair<unsigned long long, int>> result;
+    for (const auto &f : *cached_factor_phi(p))
+    {
+        int e = 0;
+        for (long long m = n; m % (long long)f.first == 0; m /= (long long)f.first)
+            ++e;
+        if (e)
+            result.push_back({f.first, e});
+    }
+    return result;
+}
+
+//* Полиг-Хеллман выгоден, когда работа по подгруппам sum(e * sqrt(q)) много меньше sqrt(n)
+static bool pohlig_hellman_favorable(long long n, const std::vector<std::pair<unsigned long long, int>> &factors)
+{
+    double cost = 0;
+    for (const auto &f : factors)
+        cost += f.second * std::sqrt((double)f.first);
+    return 4 * cost < std::sqrt((double)n);
+}
+
+//* Логарифм h по основанию g, порядок g — простое q: BSGS до 2^36, выше — ро-метод
+static long long dlog_prime_order(long long g, long long h, long long p, unsigned long long q)
+{
+    long long x = q < (1ULL << 36) ? bsgs_steps(g, h, p, (long long)q, (long long)ceil(sqrt((double)q)), false)
+                                   : dlog_rho(g, h, p);
+    return x < 0 ? -1 : x % (long long)q;
+}
+
+//* ---- Индексное исчисление ----
+// Логарифмы считаются по модулю большого простого делителя q числа p - 1 (остальная
+// часть p - 1 решается методом Полига-Хеллмана). База множителей — 2 и простые таблицы
+// TRIAL (< 4096), логарифмы L_l = log_g(l) mod q по образующей g.
+// Соотношение: z = l_c * g^k mod p восстанавливается дробью A / B с A, |B| ~ sqrt(p)
+// (расширенный Евклид по (p, z) обрывается на остатке < sqrt(p)). Если A и B гладкие:
+//   L_c + k ≡ sum e_l * L_l - sum f_l * L_l (mod q),
+// знак B не важен: log_g(-1) = (p - 1) / 2 ≡ 0 (mod q) для нечётного q.
+// Гладкость двух 31-битных чисел примерно в 50 раз вероятнее, чем одного 62-битного.
+// Множитель l_c перебирает столбцы по кругу, чтобы в соотношения попадали и редкие
+// простые базы. Решение — исключением Гаусса по модулю q: база всего ~570 столбцов,
+// плотная матрица в форме Монтгомери обходится дешевле структурированного исключения.
+
+constexpr int IC_COLUMNS = TRIAL_COUNT + 1; // столбец 0 — двойка, i + 1 — TRIAL.prime[i]
+constexpr unsigned long long IC_MIN_Q = 1ULL << 40;
+
+static unsigned long long add_mod(unsigned long long u, unsigned long long v, unsigned long long n)
+{
+    return u >= n - v ? u - (n - v) : u + v;
+}
+
+static unsigned long long ic_prime(int col)
+{
+    return col == 0 ? 2 : TRIAL.prime[col - 1];
+}
+
+//* Разложение v по базе: к exps добавляются (столбец, sign * степень); false — v не гладкое
+static bool ic_factor(unsigned long long v, int sign, std::vector<std::pair<int, int>> &exps)
+{
+    if (v == 0)
+        return false;
+    int twos = __builtin_ctzll(v);
+    if (twos)
+        exps.push_back({0, sign * twos});
+    v >>= twos;
+    for (int i = v > 1 ? trial_divisor(v) : -1; i >= 0; i = v > 1 ? trial_divisor(v, i + 1) : -1)
+    {
+        int e = 0;
+        while (v * TRIAL.inv[i] <= TRIAL.lim[i])
+        {
+            v *= TRIAL.inv[i];
+            ++e;
+        }
+        exps.push_back({i + 1, sign * e});
+    }
+    return v == 1;
+}
+
+//* z ≡ A / B (mod p), A < bound: остатки r_i ≡ t_i * z (mod p) расширенного Евклида по (p, z).
+//* Если A и |B| гладкие — разложение A минус разложение |B| в exps
+static bool ic_smooth_fraction(unsigned long long z, unsigned long long p, unsigned long long bound,
+                               std::vector<std::pair<int, int>> &exps)
+{
+    unsigned long long r0 = p, r1 = z;
+    long long t0 = 0, t1 = 1;
+    while (r1 >= bound)
+    {
+        unsigned long long q = r0 / r1, r2 = r0 - q * r1;
+        long long t2 = t0 - (long long)q * t1;
+        r0 = r1;
+        r1 = r2;
+        t0 = t1;
+        t1 = t2;
+    }
+    exps.clear();
+    return ic_factor(r1, 1, exps) && ic_factor((unsigned long long)(t1 < 0 ? -t1 : t1), -1, exps);
+}
+
+//* Логарифмы базы множителей по модулю q для простого p
+struct IndexCalculusBase
+{
+    long long p, g;
+    unsigned long long q;
+    long long h;                          // g^((p-1)/q) — образующая подгруппы порядка q
+    std::vector<unsigned long long> logs; // L_l mod q по столбцам
+};
+
+//* Соотношение: sum row[col] * L_col ≡ rhs (mod q)
+struct IcRelation
+{
+    std::vector<std::pair<int, int>> exps;
+    unsigned long long rhs;
+};
+
+//* Ступенчатая форма по модулю q в форме Монтгомери: строки добавляются по одной,
+//* строка с ведущим столбцом c нормирована (1 в столбце c, нули левее)
+class IcMatrix
+{
+public:
+    explicit IcMatrix(unsigned long long q) : ctx(q), pivot(IC_COLUMNS) {}
+
+    int rank() const { return rows; }
+    bool has_pivot(int col) const { return !pivot[col].empty(); }
+
+    void add(const IcRelation &rel)
+    {
+        const unsigned long long q = ctx.n;
+        std::vector<unsigned long long> row(IC_COLUMNS + 1, 0);
+        for (const auto &e : rel.exps)
+        {
+            unsigned long long c = e.second >= 0 ? (unsigned long long)e.second : q - (unsigned long long)(-e.second);
+            row[e.first] = add_mod(row[e.first], c, q);
+        }
+        row[IC_COLUMNS] = rel.rhs % q;
+        for (auto &v : row)
+            v = ctx.to_mont(v);
+
+        for (int c = 0; c < IC_COLUMNS; ++c)
+        {
+            if (row[c] == 0)
+                continue;
+            if (pivot[c].empty())
+            {
+                // нормировка: ведущий элемент — единица
+                unsigned long long inv = ctx.to_mont(inverse_euclid(ctx.from_mont(row[c]), q));
+                for (int k = c; k <= IC_COLUMNS; ++k)
+                    row[k] = ctx.mul(row[k], inv);
+                pivot[c] = std::move(row);
+                ++rows;
+                return;
+            }
+            const unsigned long long f = row[c];
+            const std::vector<unsigned long long> &pr = pivot[c];
+            for (int k = c; k <= IC_COLUMNS; ++k)
+                if (pr[k])
+                    row[k] = sub_mod(row[k], ctx.mul(f, pr[k]), q);
+        }
+    }
+
+    //* Обратная подстановка (все столбцы ведущие)
+    std::vector<unsigned long long> solve() const
+    {
+        const unsigned long long q = ctx.n;
+        std::vector<unsigned long long> x(IC_COLUMNS, 0); // в форме Монтгомери
+        for (int c = IC_COLUMNS - 1; c >= 0; --c)
+        {
+            const std::vector<unsigned long long> &pr = pivot[c];
+            unsigned long long v = pr[IC_COLUMNS];
+            for (int k = c + 1; k < IC_COLUMNS; ++k)
+                if (pr[k])
+                    v = sub_mod(v, ctx.mul(pr[k], x[k]), q);
+            x[c] = v;
+        }
+        for (auto &v : x)
+            v = ctx.from_mont(v);
+        return x;
+    }
+
+private:
+    static unsigned long long sub_mod(unsigned long long u, unsigned long long v, unsigned long long n)
+    {
+        return u >= v ? u - v : u + (n - v);
+    }
+
+    MontgomeryContext ctx;
+    std::vector<std::vector<unsigned long long>> pivot;
+    int rows = 0;
+};
+
+//* Сбор соотношений в threads потоках: соотношение j берёт множитель столбца cols[j % size]
+static std::vector<IcRelation> ic_collect(const IndexCalculusBase &base, const std::vector<int> &cols, size_t count,
+                                          int threads)
+{
+    const unsigned long long p = (unsigned long long)base.p;
+    const unsigned long long bound = (unsigned long long)std::sqrt((double)p) + 1;
+    std::vector<IcRelation> result(count);
+    std::atomic<size_t> next(0);
+    unsigned long long nthreads = threads > 0 ? (unsigned long long)threads : hardware_threads();
+    std::vector<unsigned long long> seeds(nthreads);
+    random_u64(seeds.data(), seeds.size());
+
+    run_workers(nthreads, [&](unsigned long long t)
+                {
+                    CryptoRng rng(seeds[t], t);
+                    const MontgomeryContext ctx(p);
+                    std::vector<std::pair<int, int>> exps;
+                    for (size_t j = next.fetch_add(1); j < count; j = next.fetch_add(1))
+                    {
+                        const int col = cols[j % cols.size()];
+                        const unsigned long long l = ctx.to_mont(ic_prime(col));
+                        while (true)
+                        {
+                            unsigned long long k = rng() % (p - 1);
+                            unsigned long long z = ctx.from_mont(ctx.mul(l, ctx.to_mont((unsigned long long)mod_pow(base.g, (long long)k, (long long)p))));
+                            if (!ic_smooth_fraction(z, p, bound, exps))
+                                continue;
+                            // L_col + k ≡ sum(...)  =>  sum(...) - L_col ≡ k
+                            exps.push_back({col, -1});
+                            result[j] = {exps, k % base.q};
+                            break;
+                        }
+                    } });
+    return result;
+}
+
+//* Логарифмы базы по модулю q: соотношения копятся, пока матрица не станет полного ранга
+static std::shared_ptr<const IndexCalculusBase> ic_build(long long p, unsigned long long q, int threads)
+{
+    auto base = std::make_shared<IndexCalculusBase>();
+    base->p = p;
+    base->q = q;
+    base->g = find_generator(p);
+    base->h = mod_pow(base->g, (p - 1) / (long long)q, p);
+
+    IcMatrix matrix(q);
+    std::vector<int> cols(IC_COLUMNS);
+    for (int c = 0; c < IC_COLUMNS; ++c)
+        cols[c] = c;
+    for (int round = 0; matrix.rank() < IC_COLUMNS; ++round)
+    {
+        if (round == 64)
+            throw std::runtime_error("index calculus: relation matrix does not reach full rank");
+        for (const auto &rel : ic_collect(*base, cols, round ? cols.size() : cols.size() + 16, threads))
+            matrix.add(rel);
+        // следующий круг — только столбцы без ведущего элемента
+        cols.clear();
+        for (int c = 0; c < IC_COLUMNS; ++c)
+            if (!matrix.has_pivot(c))
+                cols.push_back(c);
+    }
+    base->logs = matrix.solve();
+
+    // проверка: l^((p-1)/q) == h^L_l — верно, только если L_l ≡ log_g(l) (mod q)
+    for (int c = 0; c < IC_COLUMNS; ++c)
+        if (mod_pow((long long)ic_prime(c), (p - 1) / (long long)q, p) != mod_pow(base->h, (long long)base->logs[c], p))
+            throw std::runtime_error("index calculus: factor base logarithm check failed");
+    return base;
+}
+
+//* Логарифмы базы для (p, q) с кэшем на процесс: повторные задачи по тому же p
+//* сразу переходят к спуску запроса
+static std::shared_ptr<const IndexCalculusBase> cached_ic_base(long long p, unsigned long long q, int threads)
+{
+    static std::mutex mtx;
+    static std::map<std::pair<long long, unsigned long long>, std::shared_ptr<const IndexCalculusBase>> cache;
+    const size_t MAX_ENTRIES = 16;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = cache.find({p, q});
+        if (it != cache.end())
+            return it->second;
+    }
+    auto base = ic_build(p, q, threads);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (cache.size() >= MAX_ENTRIES)
+        cache.clear();
+    cache[{p, q}] = base;
+    return base;
+}
+
+//* log_g(z) mod q: z * g^k со случайным k до гладкой дроби, затем сумма логарифмов базы
+static unsigned long long ic_log(const IndexCalculusBase &base, long long z)
+{
+    const unsigned long long p = (unsigned long long)base.p, q = base.q;
+    const unsigned long long bound = (unsigned long long)std::sqrt((double)p) + 1;
+    const long long zq = mod_pow(z, (base.p - 1) / (long long)q, base.p);
+    std::vector<std::pair<int, int>> exps;
+    while (true)
+    {
+        unsigned long long k = random_u64() % (p - 1);
+        unsigned long long w = (unsigned long long)((unsigned __int128)(unsigned long long)z * (unsigned long long)mod_pow(base.g, (long long)k, base.p) % p);
+        if (!ic_smooth_fraction(w, p, bound, exps))
+            continue;
+        // log z ≡ sum e_l * L_l - k (mod q)
+        unsigned long long log = q - k % q;
+        for (const auto &e : exps)
+        {
+            unsigned long long term = (unsigned long long)((unsigned __int128)base.logs[e.first] * (unsigned long long)(e.second < 0 ? -e.second : e.second) % q);
+            log = e.second > 0 ? add_mod(log % q, term, q) : add_mod(log % q, (q - term) % q, q);
+        }
+        log %= q;
+        if (mod_pow(base.h, (long long)log, base.p) == zq)
+            return log;
+    }
+}
+
+//* Полиг-Хеллман при известном порядке n элемента a и y из <a>: в каждой подгруппе
+//* порядка q^e показатель находится по цифрам в системе q (e логарифмов в подгруппе
+//* порядка q), затем остатки x mod q^e собираются по КТО
+//* ic — логарифмы базы индексного исчисления: подгруппа порядка ic->q решается им
+static long long pohlig_hellman(long long a, long long y, long long p, long long n,
+                                const std::vector<std::pair<unsigned long long, int>> &factors,
+                                const IndexCalculusBase *ic = nullptr)
+{
+    const long long a_inv = mod_inverse(a, p);
+    long long x = 0, mod = 1; // x mod (произведение обработанных q^e)
+    for (const auto &f : factors)
+    {
+        const long long q = (long long)f.first;
+        long long qe = 1;
+        for (int i = 0; i < f.second; ++i)
+            qe *= q;
+
+        const long long gamma = mod_pow(a, n / q, p); // образующая подгруппы порядка q
+        long long xq = 0, qk = 1;                     // xq = x mod q^k
+        for (int k = 0; k < f.second; ++k)
+        {
+            // (y * a^-xq)^(n / q^(k+1)) лежит в подгруппе порядка q
+            long long h = (long long)((unsigned __int128)y * (unsigned long long)mod_pow(a_inv, xq, p) % (unsigned long long)p);
+            h = mod_pow(h, n / (qk * q), p);
+            long long d;
+            if (ic && (unsigned long long)q == ic->q)
+            {
+                // log_gamma(h) = log_g(h) / log_g(gamma) (mod q); gamma порядка q, log_g(gamma) != 0
+                unsigned long long lg = ic_log(*ic, gamma), lh = ic_log(*ic, h);
+                d = (long long)((unsigned __int128)lh * inverse_euclid(lg, (unsigned long long)q) % (unsigned long long)q);
+            }
+            else
+                d = dlog_prime_order(gamma, h, p, (unsigned long long)q);
+            if (d < 0)
+                return -1;
+            xq += d * qk;
+            qk *= q;
+        }
+
+        // КТО: x ≡ x (mod mod), x ≡ xq (mod qe)
+        long long inv = mod_inverse(mod % qe, qe);
+        long long t = (long long)((unsigned __int128)(((xq - x % qe) % qe + qe) % qe) * (unsigned long long)inv % (unsigned long long)qe);
+        x += mod * t;
+        mod *= qe;
+    }
+    return x;
+}
+
+long long dlog_pohlig_hellman(long long a, long long y, long long p)
+{
+    if (p < 3 || !(p & 1) || !is_probably_prime(p, 0))
+        throw std::invalid_argument("dlog_pohlig_hellman: p must be an odd prime");
+    a = ((a % p) + p) % p;
+    y = ((y % p) + p) % p;
+    if (a == 0 || y == 0)
+        return -1;
+    if (y == 1)
+        return 0;
+
+    const long long n = element_order(a, p);
+    if (mod_pow(y, n, p) != 1)
+        return -1; // y не лежит в <a>
+    return pohlig_hellman(a, y, p, n, order_factors(n, p));
+}
+
+long long dlog_index_calculus(long long a, long long y, long long p, int threads)
+{
+    if (p < 3 || !(p & 1) || !is_probably_prime(p, 0))
+        throw std::invalid_argument("dlog_index_calculus: p must be an odd prime");
+    a = ((a % p) + p) % p;
+    y = ((y % p) + p) % p;
+    if (a == 0 || y == 0)
+        return -1;
+    if (y == 1)
+        return 0;
+
+    const long long n = element_order(a, p);
+    if (mod_pow(y, n, p) != 1)
+        return -1; // y не лежит в <a>
+    auto factors = order_factors(n, p);
+
+    // индексное исчисление — для наибольшего простого делителя порядка, если он велик;
+    // остальные подгруппы дёшевы для BSGS / ро-метода
+    std::shared_ptr<const IndexCalculusBase> base;
+    if (!factors.empty() && factors.back().first >= IC_MIN_Q)
+        base = cached_ic_base(p, factors.back().first, threads);
+    long long x = pohlig_hellman(a, y, p, n, factors, base.get());
+    return x >= 0 && mod_pow(a, x, p) == y ? x : -1;
+}
+
+//* Для простого p с гладким порядком a (см. pohlig_hellman_favorable) задача решается
+//* методом Полига-Хеллмана, иначе — BSGS по всей группе
+long long API bsgs(long long a, long long y, long long p)
+{
+    if (p < 2)
+        return -1;
+    if (p > 3 && (p & 1) && a % p != 0 && y % p != 0 && is_probably_prime(p, 0))
+    {
+        long long ar = ((a % p) + p) % p, yr = ((y % p) + p) % p;
+        const long long n = element_order(ar, p);
+        auto factors = order_factors(n, p);
+        if (pohlig_hellman_favorable(n, factors))
         {
-            // используем 128-bit, чтобы избежать переполнения
-            __int128 t = (__int128)result * (__int128)cur;
-            result = (long long)(t % mod);
+            if (yr == 1)
+                return 0;
+            return mod_pow(yr, n, p) == 1 ? pohlig_hellman(ar, yr, p, n, factors) : -1;
         }
-        __int128 t2 = (__int128)cur * (__int128)cur;
-        cur = (long long)(t2 % mod);
-        exp >>= 1;
     }
-    return result;
+    return bsgs_steps(a, y, p, p, (long long)ceil(sqrt(p)), false);
 }
 
-//* Тест Миллера-Рабина на простоту + быстрая фильтрация
-bool is_probably_prime(long long n, int k)
+long long bsgs_bounded(long long a, long long y, long long p, size_t memory_bytes, bool huge_pages)
 {
-    if (n < 2)
-        return false;
-    // небольшие простые
-    for (int i = 0; i < SMALL_PRIMES_COUNT; ++i)
-    {
-        int p = SMALL_PRIMES_ARR[i];
-        if (n == p)
-            return true;
-        if (n % p == 0)
-            return false;
-    }
+    if (p < 2)
+        return -1;
+    // наибольшая таблица (степень двойки слотов по 8 байт), помещающаяся в бюджет
+    size_t cap = 0;
+    for (size_t c = BabyStepTable::capacity_for(0); c * sizeof(unsigned long long) <= memory_bytes; c <<= 1)
+        cap = c;
+    if (cap == 0)
+        throw std::invalid_argument("bsgs_bounded: memory budget is too small");
+    long long m = std::min((long long)ceil(sqrt(p)), (long long)(cap / 2));
+    return bsgs_steps(a, y, p, p, m, huge_pages);
+}
 
-    // представим n-1 = d * 2^s
-    long long d = n - 1;
-    int s = 0;
-    while ((d & 1) == 0)
-    {
-        d >>= 1;
-        ++s;
-    }
+//* Многопоточный BSGS. Таблица шагов младенца делится на шарды по отдельному хэшу ключа
+//* (старшие биты key * SHARD_MUL — независимо от слота внутри шарда):
+//*   1) поток t считает свой отрезок j и раскладывает пары (ключ, j) по шардам;
+//*   2) поток s вставляет в шард s записи всех потоков — шард заполняет один поток;
+//*   3) шаги великана раздаются блоками по BSGS_GIANT_CHUNK через общий счётчик,
+//*      первый найденный x останавливает остальные потоки
+long long bsgs_parallel(long long a, long long y, long long p, int threads)
+{
+    if (p < 3 || !(p & 1))
+        return bsgs(a, y, p);
+    const long long m = (long long)ceil(sqrt(p));
+    const long long target = ((y % p) + p) % p;
+    a = ((a % p) + p) % p;
 
-    auto try_composite = [&](long long a) -> bool
-    {
-        long long x = mod_pow(a, d, n);
-        if (x == 1 || x == n - 1)
-            return false;
-        for (int r = 1; r < s; ++r)
-        {
-            x = mod_pow(x, 2, n);
-            if (x == n - 1)
-                return false;
-            if (x == 1)
-                return true; // составное
-        }
-        return true; // точно составное
-    };
+    unsigned long long nthreads = threads > 0 ? (unsigned long long)threads : hardware_threads();
+    // меньше 2^16 шагов младенца на поток не выгодно: запуск потока дороже
+    nthreads = std::max(1ULL, std::min<unsigned long long>(nthreads, (unsigned long long)m >> 16));
+    if (nthreads == 1)
+        return bsgs_steps(a, y, p, p, m, false);
+
+    const unsigned long long SHARD_MUL = 0xC2B2AE3D27D4EB4FULL;
+    int shard_bits = 0;
+    while ((1ULL << shard_bits) < nthreads)
+        ++shard_bits;
+    const size_t shards = (size_t)1 << shard_bits;
+    auto shard_of = [&](unsigned long long key) { return (size_t)((key * SHARD_MUL) >> (63 - shard_bits) >> 1); };
+
+    const MontgomeryContext ctx((unsigned long long)p);
+    const unsigned long long a_mont = ctx.to_mont((unsigned long long)a);
+
+    // 1) шаги младенца y * a^j по отрезкам j; a^j == 1 внутри отрезка — порядок a меньше m
+    std::atomic<bool> short_order(false);
+    std::vector<std::vector<std::vector<std::pair<unsigned long long, uint32_t>>>> parts(
+        nthreads, std::vector<std::vector<std::pair<unsigned long long, uint32_t>>>(shards));
+    run_workers(nthreads, [&](unsigned long long t)
+                {
+                    long long from = m * (long long)t / (long long)nthreads;
+                    long long to = m * (long long)(t + 1) / (long long)nthreads;
+                    for (auto &part : parts[t])
+                        part.reserve((size_t)(to - from) / shards + (size_t)(to - from) / (4 * shards) + 16);
+                    unsigned long long a_pow = ctx.to_mont((unsigned long long)mod_pow(a, from, p));
+                    unsigned long long value = ctx.mul(ctx.to_mont((unsigned long long)target), a_pow);
+                    for (long long j = from; j < to && !short_order.load(std::memory_order_relaxed); j++)
+                    {
+                        parts[t][shard_of(value)].push_back({value, (uint32_t)j});
+                        value = ctx.mul(value, a_mont);
+                        a_pow = ctx.mul(a_pow, a_mont);
+                        if (a_pow == ctx.r)
+                            short_order.store(true, std::memory_order_relaxed);
+                    } });
+    // порядок a меньше m: шаги младенца повторяются, bsgs_steps остановит их на порядке
+    if (short_order.load())
+        return bsgs_steps(a, y, p, p, m, false);
+
+    // 2) шарды: поток s заполняет шарды s, s + nthreads, ...
+    std::vector<std::unique_ptr<BabyStepTable>> tables(shards);
+    run_workers(nthreads, [&](unsigned long long t)
+                {
+                    for (size_t s = (size_t)t; s < shards; s += (size_t)nthreads)
+                    {
+                        size_t count = 0;
+                        for (auto &part : parts)
+                            count += part[s].size();
+                        tables[s].reset(new BabyStepTable(count));
+                        for (auto &part : parts)
+                        {
+                            for (auto &e : part[s])
+                                tables[s]->insert(e.first, e.second);
+                            std::vector<std::pair<unsigned long long, uint32_t>>().swap(part[s]);
+                        }
+                    } });
 
-    // Если пользователь указал k > 0, исполним k случайных тестов
-    if (k > 0)
+    // 3) шаги великана (a^m)^i, i <= p / m, блоками
+    const long long BSGS_GIANT_CHUNK = 1 << 14;
+    const long long giant = p / m + 1;
+    const long long a_m_plain = mod_pow(a, m, p);
+    const unsigned long long a_m = ctx.to_mont((unsigned long long)a_m_plain);
+    std::atomic<long long> next_chunk(0);
+    std::atomic<long long> result(-1);
+    run_workers(nthreads, [&](unsigned long long)
+                {
+                    long long i = 0;
+                    auto verify = [&](uint32_t j)
+                    {
+                        long long cand = i * m - (long long)j;
+                        if (cand < 0 || mod_pow(a, cand, p) != target)
+                            return false;
+                        result.store(cand % (p - 1), std::memory_order_relaxed);
+                        return true;
+                    };
+                    while (result.load(std::memory_order_relaxed) < 0)
+                    {
+                        long long from = next_chunk.fetch_add(1, std::memory_order_relaxed) * BSGS_GIANT_CHUNK;
+                        if (from > giant)
+                            return;
+                        long long to = std::min(giant + 1, from + BSGS_GIANT_CHUNK);
+                        unsigned long long gamma = ctx.to_mont((unsigned long long)mod_pow(a_m_plain, from, p));
+                        for (i = from; i < to; i++)
+                        {
+                            if (tables[shard_of(gamma)]->find(gamma, verify))
+                                return;
+                            if ((i & 1023) == 0 && result.load(std::memory_order_relaxed) >= 0)
+                                return;
+                            gamma = ctx.mul(gamma, a_m);
+                        }
+                    } });
+
+    return result.load();
+}
+
+//* ---- Таблица дискретного логарифма ----
+// Файл (64-битные числа в порядке байт машины): заголовок DlogTableHeader (64 байта),
+// затем capacity слотов BabyStepTable. Ключи — a^j в форме Монтгомери по модулю p:
+// форма зависит только от p, поэтому таблица переносима между процессами
+
+struct DlogTableHeader
+{
+    char magic[8];
+    unsigned long long version;
+    unsigned long long base;
+    unsigned long long mod;
+    unsigned long long m;
+    unsigned long long capacity;
+    unsigned long long reserved[2];
+};
+
+static const char DLOG_MAGIC[8] = {'D', 'L', 'O', 'G', 'T', 'A', 'B', 'L'};
+
+DlogTable::DlogTable(long long base, long long mod, long long steps) : a(base), p(mod), m(steps)
+{
+    if (p < 3 || !(p & 1))
+        throw std::invalid_argument("DlogTable: mod must be odd and > 2");
+    a = ((a % p) + p) % p;
+    if (m <= 0)
+        m = (long long)ceil(sqrt(p));
+    if (m > p)
+        m = p;
+    if (m > UINT32_MAX)
+        throw std::invalid_argument("DlogTable: too many baby steps");
+    long long a_inv = mod_inverse(a, p);
+    if (a_inv < 0)
+        throw std::invalid_argument("DlogTable: base is not invertible modulo mod");
+
+    const MontgomeryContext ctx((unsigned long long)p);
+    step = ctx.to_mont((unsigned long long)mod_pow(a_inv, m, p));
+    table.reset(new BabyStepTable((size_t)m));
+
+    // Шаги младенца: a^j до возврата к 1 — тогда m сокращается до порядка a
+    // (step = a^(-m) = 1, solve обходится одним поиском)
+    const unsigned long long a_mont = ctx.to_mont((unsigned long long)a);
+    unsigned long long value = ctx.r;
+    for (long long j = 0; j < m; j++)
     {
-        std::uniform_int_distribution<unsigned long long> dist(2, (unsigned long long)(n - 2));
-        for (int i = 0; i < k; ++i)
+        table->insert(value, (uint32_t)j);
+        value = ctx.mul(value, a_mont);
+        if (value == ctx.r)
         {
-            long long a = (long long)dist(CRYPTO_RNG);
-            if (try_composite(a))
-                return false;
+            m = j + 1;
+            step = ctx.r;
+            break;
         }
-        return true; // вероятно простое
     }
+}
 
-    // k <= 0: используем детерминированный набор оснований, достаточный для 64-bit.
-    long long bases[] = {2LL, 325LL, 9375LL, 28178LL, 450775LL, 9780504LL, 1795265022LL};
-    for (long long a : bases)
+DlogTable::DlogTable(const std::string &path)
+{
+#ifdef _WIN32
+    throw std::runtime_error("DlogTable: memory-mapped tables are not supported on this platform");
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("DlogTable: cannot open " + path);
+    struct stat st;
+    DlogTableHeader header{};
+    bool ok = ::fstat(fd, &st) == 0 && ::pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+              std::memcmp(header.magic, DLOG_MAGIC, sizeof(DLOG_MAGIC)) == 0 && header.version == 1 &&
+              header.mod >= 3 && (header.mod & 1) && !(header.mod >> 63) && header.base > 0 &&
+              header.base < header.mod && std::gcd(header.base, header.mod) == 1 && header.m > 0 && header.m <= UINT32_MAX &&
+              // m сокращается до порядка base, если он меньше, — ёмкость от исходного m
+              header.capacity >= BabyStepTable::capacity_for(header.m) && header.capacity <= BabyStepTable::capacity_for(UINT32_MAX) &&
+              (header.capacity & (header.capacity - 1)) == 0 &&
+              (unsigned long long)st.st_size == sizeof(header) + header.capacity * sizeof(unsigned long long);
+    if (!ok)
     {
-        if (a % n == 0)
-            return true;
-        if (try_composite(a % n))
-            return false;
+        ::close(fd);
+        throw std::runtime_error("DlogTable: bad table file: " + path);
     }
-    return true;
+
+    size_t size = (size_t)st.st_size;
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // отображение остаётся действительным
+    if (map == MAP_FAILED)
+        throw std::runtime_error("DlogTable: cannot mmap " + path);
+
+    a = (long long)header.base;
+    p = (long long)header.mod;
+    m = (long long)header.m;
+    step = MontgomeryContext((unsigned long long)p).to_mont((unsigned long long)mod_pow(mod_inverse(a, p), m, p));
+    table.reset(new BabyStepTable(map, size, (unsigned long long *)((unsigned char *)map + sizeof(header)),
+                                  (size_t)header.capacity));
+#endif
 }
 
-//* Генерация случайного простого числа в диапазоне low-high
-long long generate_prime(long long low, long long high)
+DlogTable::~DlogTable() = default;
+
+void DlogTable::save(const std::string &path) const
 {
-    if (low < 2)
-        low = 2;
-    if (high < low)
-        std::swap(low, high);
+    DlogTableHeader header{};
+    std::memcpy(header.magic, DLOG_MAGIC, sizeof(DLOG_MAGIC));
+    header.version = 1;
+    header.base = (unsigned long long)a;
+    header.mod = (unsigned long long)p;
+    header.m = (unsigned long long)m;
+    header.capacity = table->capacity();
 
-    // корректируем границы к нечётным и минимум 3
-    long long lo = (low % 2 == 0) ? low + 1 : low;
-    if (lo < 3)
-        lo = 3;
-    long long hi = (high % 2 == 0) ? high - 1 : high;
-    if (lo > hi)
-        throw std::runtime_error("generate_prime: no candidates");
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)table->data(), (std::streamsize)(table->capacity() * sizeof(unsigned long long)));
+    if (!out)
+        throw std::runtime_error("DlogTable: cannot write " + path);
+}
+
+long long DlogTable::solve(long long y) const
+{
+    long long x;
+    solve(&y, &x, 1);
+    return x;
+}
+
+//* Шаги великана y * a^(-m*i), i <= (p - 1) / m; совпадение с a^j даёт x = i * m + j
+//* (проверяется возведением в степень). До LANES запросов идут вперемешку: поиски
+//* в таблице разных запросов независимы, их промахи кэша перекрываются
+void DlogTable::solve(const long long *ys, long long *out, size_t n) const
+{
+    const int LANES = 8;
+    const MontgomeryContext ctx((unsigned long long)p);
+    // step == 1: m — порядок a, все x < m уже в таблице
+    const long long giant = step == ctx.r ? 0 : (p - 1) / m + 1;
 
-    long long range = (hi - lo) / 2 + 1;
-    std::uniform_int_distribution<unsigned long long> dist_idx(0, (unsigned long long)(range - 1));
+    size_t query[LANES];
+    unsigned long long gamma[LANES];
+    long long step_i[LANES];
+    long long target[LANES];
+    size_t next = 0;
 
-    const int MAX_RANDOM_TRIES = 2000;
-    const int MR_ROUNDS = 7; // количество раундов Miller-Rabin (при k>0)
-    for (int attempt = 0; attempt < MAX_RANDOM_TRIES; ++attempt)
+    // следующий запрос в дорожку l; false — запросы кончились
+    auto start = [&](int l)
     {
-        long long idx = (long long)dist_idx(CRYPTO_RNG);
-        long long cand = lo + idx * 2;
-        // trial division quickly
-        bool pass_trial = true;
-        for (int i = 0; i < SMALL_PRIMES_COUNT; ++i)
+        while (next < n)
         {
-            int p = SMALL_PRIMES_ARR[i];
-            if (cand == p)
-                return cand;
-            if (cand % p == 0)
+            size_t q = next++;
+            long long y = ((ys[q] % p) + p) % p;
+            if (y == 0)
             {
-                pass_trial = false;
-                break;
+                out[q] = -1;
+                continue;
             }
+            query[l] = q;
+            target[l] = y;
+            gamma[l] = ctx.to_mont((unsigned long long)y);
+            step_i[l] = 0;
+            return true;
         }
-        if (!pass_trial)
-            continue;
-        if (is_probably_prime(cand, MR_ROUNDS))
-            return cand;
-    }
+        return false;
+    };
 
-    // Если случайное не сработало, делаем последовательный проход
-    long long start_idx = dist_idx(CRYPTO_RNG);
-    for (long long i = 0; i < range; ++i)
+    int active = 0;
+    while (active < LANES && start(active))
+        ++active;
+
+    while (active > 0)
     {
-        long long idx = (start_idx + i) % range;
-        long long cand = lo + idx * 2;
-        bool pass_trial = true;
-        for (int j = 0; j < SMALL_PRIMES_COUNT; ++j)
+        for (int l = 0; l < active; ++l)
+            table->prefetch(gamma[l]);
+        for (int l = 0; l < active;)
         {
-            int p = SMALL_PRIMES_ARR[j];
-            if (cand == p)
-                return cand;
-            if (cand % p == 0)
+            long long x = -1;
+            auto verify = [&](uint32_t j)
             {
-                pass_trial = false;
-                break;
+                long long cand = step_i[l] * m + (long long)j;
+                if (mod_pow(a, cand, p) != target[l])
+                    return false;
+                x = cand % (p - 1);
+                return true;
+            };
+            bool done = table->find(gamma[l], verify);
+            if (!done)
+            {
+                gamma[l] = ctx.mul(gamma[l], step);
+                done = ++step_i[l] > giant;
+            }
+            if (!done)
+            {
+                ++l;
+                continue;
             }
+            out[query[l]] = x;
+            if (start(l))
+                continue;
+            // дорожка освободилась: на её место — последняя активная
+            --active;
+            query[l] = query[active];
+            target[l] = target[active];
+            gamma[l] = gamma[active];
+            step_i[l] = step_i[active];
         }
-        if (!pass_trial)
-            continue;
-        if (is_probably_prime(cand, MR_ROUNDS))
-            return cand;
     }
-
-    throw std::runtime_error("generate_prime: no prime found in range");
 }
 
-long long find_generator(long long p)
+//* Номер прыжка по точке блуждания: старшие биты мультипликативного хэша
+static unsigned walk_index(unsigned long long x, unsigned long long salt, unsigned count)
 {
-    if (p <= 2)
-        return -1; // для p<=2 нет смысла
+    return (unsigned)(((x ^ salt) * 0x9E3779B97F4A7C15ULL) >> 40) % count;
+}
 
-    // Опционально: требуем, чтобы p было простым (для простой и корректной работы)
-    if (!is_probably_prime(p, 5))
-        return -1;
+//* Блуждание ро-метода с r добавлениями (Теске): x <- x * M_k, M_k = a^s_k * y^t_k, k = h(x);
+//* точка хранит свои показатели: x = a^u * y^v (x в форме Монтгомери).
+//* Множители и соль берутся из rng: одинаковое зерно — одинаковая функция шага
+struct RhoWalk
+{
+    static const unsigned R = 20;
 
-    std::vector<long long> factors;
-    long long phi = p - 1;
-    long long n = phi;
+    MontgomeryContext ctx;
+    long long a, y;
+    unsigned long long n, salt;
+    unsigned long long mult[R], s[R], t[R];
 
-    // 1. Разложение phi = p-1 на простые множители (без повторов)
-    for (long long i = 2; i * i <= n; i++)
+    RhoWalk(long long a, long long y, long long p, unsigned long long n, CryptoRng &rng)
+        : ctx((unsigned long long)p), a(a), y(y), n(n)
     {
-        if (n % i == 0)
+        salt = rng();
+        for (unsigned k = 0; k < R; ++k)
         {
-            factors.push_back(i);
-            while (n % i == 0)
-                n /= i;
+            s[k] = rng() % n;
+            t[k] = rng() % n;
+            mult[k] = point(s[k], t[k]);
         }
     }
-    if (n > 1)
-        factors.push_back(n);
 
-    // 2. Перебор кандидатов g
-    for (long long g = 2; g < p; g++)
+    unsigned long long point(unsigned long long u, unsigned long long v) const
     {
-        bool ok = true;
-        for (long long f : factors)
+        const long long p = (long long)ctx.n;
+        return ctx.mul(ctx.to_mont((unsigned long long)mod_pow(a, (long long)u, p)),
+                       ctx.to_mont((unsigned long long)mod_pow(y, (long long)v, p)));
+    }
+
+    void step(unsigned long long &x, unsigned long long &u, unsigned long long &v) const
+    {
+        unsigned k = walk_index(x, salt, R);
+        x = ctx.mul(x, mult[k]);
+        u = add_mod(u, s[k], n);
+        v = add_mod(v, t[k], n);
+    }
+};
+
+//* Совпадение точек блуждания a^u1 * y^v1 == a^u2 * y^v2 в группе порядка n:
+//* (v2 - v1) * x ≡ u1 - u2 (mod n). Решений gcd(v2 - v1, n) — каждое (если их не больше 2^16)
+//* проверяется возведением в степень. -1 — совпадение вырожденное
+static long long rho_collision(long long a, long long y, long long p, unsigned long long n,
+                               unsigned long long u1, unsigned long long v1, unsigned long long u2, unsigned long long v2)
+{
+    const unsigned long long MAX_SOLUTIONS = 1u << 16;
+    unsigned long long dv = v2 >= v1 ? v2 - v1 : v2 + (n - v1);
+    unsigned long long du = u1 >= u2 ? u1 - u2 : u1 + (n - u2);
+    unsigned long long d = std::gcd(dv, n);
+    if (dv == 0 || d > MAX_SOLUTIONS || du % d != 0)
+        return -1;
+    const unsigned long long nd = n / d;
+    unsigned long long inv = nd == 1 ? 0 : inverse_euclid((dv / d) % nd, nd);
+    unsigned long long x0 = (unsigned long long)((unsigned __int128)(du / d) * inv % nd);
+    for (unsigned long long i = 0; i < d; ++i)
+    {
+        long long cand = (long long)(x0 + i * nd);
+        if (mod_pow(a, cand, p) == y)
+            return cand;
+    }
+    return -1;
+}
+
+long long dlog_rho(long long a, long long y, long long p)
+{
+    if (p < 3 || !(p & 1) || !is_probably_prime(p, 0))
+        throw std::invalid_argument("dlog_rho: p must be an odd prime");
+    a = ((a % p) + p) % p;
+    y = ((y % p) + p) % p;
+    if (a == 0 || y == 0)
+        return -1;
+    if (y == 1)
+        return 0;
+
+    // y лежит в <a>, только если y^n == 1 (группа по простому модулю циклическая)
+    const unsigned long long n = (unsigned long long)element_order(a, p);
+    if (mod_pow(y, (long long)n, p) != 1)
+        return -1;
+
+    // Блуждание RhoWalk, цикл ищется методом Брента
+    for (int attempt = 0; attempt < 32; ++attempt)
+    {
+        CryptoRng &rng = crypto_rng();
+        const RhoWalk walk(a, y, p, n, rng);
+        unsigned long long u = rng() % n, v = rng() % n;
+        unsigned long long x = walk.point(u, v);
+        unsigned long long xs = x, us = u, vs = v; // точка-«черепаха»
+        unsigned long long power = 1, lam = 0;
+        while (true)
         {
-            if (mod_pow(g, phi / f, p) == 1)
-            {
-                ok = false;
+            walk.step(x, u, v);
+            ++lam;
+            if (x == xs)
                 break;
+            if (lam == power)
+            {
+                xs = x;
+                us = u;
+                vs = v;
+                power <<= 1;
+                lam = 0;
             }
         }
-        if (ok)
-            return g; // найден генератор
+
+        long long res = rho_collision(a, y, p, n, u, v, us, vs);
+        if (res >= 0)
+            return res;
     }
+    return -1;
+}
 
-    return -1; // если не нашли
+//* ---- Распределённый ро-метод (выделенные точки) ----
+// Координатор рассылает рабочим задание DlogTask; все рабочие идут блужданиями RhoWalk
+// с общей функцией шага (зерно walk_seed) из своих случайных точек (start_seed) и
+// присылают выделенные точки DlogPoint — у которых старшие dp_bits бит хэша нулевые.
+// Две выделенные точки с одним x и разными (u, v) — встреча блужданий, она даёт x.
+// Сообщения фиксированного размера, числа в порядке байт машины (у узлов он должен совпадать).
+// Рабочий завершается, когда координатор закрывает соединение.
+
+struct DlogTask
+{
+    char magic[8];
+    unsigned long long a, y, p, n;
+    unsigned long long walk_seed, start_seed, dp_bits;
+};
+
+struct DlogPoint
+{
+    unsigned long long x, u, v;
+};
+
+static const char DLOG_TASK_MAGIC[8] = {'D', 'L', 'O', 'G', 'T', 'A', 'S', 'K'};
+
+#ifndef _WIN32
+//* Запись всего буфера; для сокетов без SIGPIPE при закрытом соединении
+static bool write_full(int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *)buf;
+    while (len > 0)
+    {
+        ssize_t w = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == ENOTSOCK)
+            w = ::write(fd, p, len);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        p += w;
+        len -= (size_t)w;
+    }
+    return true;
 }
 
-std::tuple<long long, long long, long long> egcd(long long a, long long b)
+static bool read_full(int fd, void *buf, size_t len)
 {
-    if (a <= 0 || b < 0)
+    char *p = (char *)buf;
+    while (len > 0)
     {
-        throw std::invalid_argument(
-            "extended_gcd: expected positive a and non-negative b");
+        ssize_t r = ::read(fd, p, len);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= (size_t)r;
     }
+    return true;
+}
+#endif
 
-    long long u1 = a, u2 = 1, u3 = 0; // U = (u1, u2, u3) = (a, 1, 0)
-    long long v1 = b, v2 = 0, v3 = 1; // V = (v1, v2, v3) = (b, 0, 1)
+void dlog_worker(int fd)
+{
+#ifdef _WIN32
+    (void)fd;
+    throw std::runtime_error("dlog_worker: not supported on this platform");
+#else
+    DlogTask task;
+    if (!read_full(fd, &task, sizeof(task)) || std::memcmp(task.magic, DLOG_TASK_MAGIC, sizeof(DLOG_TASK_MAGIC)) != 0 ||
+        task.p < 3 || !(task.p & 1) || task.p >> 63 || task.n == 0 || task.dp_bits > 32)
+        return;
 
-    while (v1 != 0)
+    CryptoRng walk_rng(task.walk_seed, 0);
+    const RhoWalk walk((long long)task.a, (long long)task.y, (long long)task.p, task.n, walk_rng);
+    CryptoRng rng(task.start_seed, 0);
+    const unsigned long long dp_mask = task.dp_bits ? ~0ULL << (64 - task.dp_bits) : 0;
+    // блуждание, попавшее в цикл без выделенных точек, бросается после 20 * 2^dp_bits шагов
+    const unsigned long long max_len = 20ULL << task.dp_bits;
+    while (true)
     {
-        long long q = u1 / v1;
-        // T = (u1 mod v1, u2 - q*v2, u3 - q*v3)
-        long long t1 = u1 % v1;
-        long long t2 = u2 - q * v2;
-        long long t3 = u3 - q * v3;
-
-        // Сдвигаем: U = V, V = T
-        u1 = v1;
-        u2 = v2;
-        u3 = v3;
-        v1 = t1;
-        v2 = t2;
-        v3 = t3;
+        unsigned long long u = rng() % task.n, v = rng() % task.n;
+        unsigned long long x = walk.point(u, v);
+        for (unsigned long long len = 0; len < max_len; ++len)
+        {
+            if (((x * 0xD6E8FEB86659FD93ULL) & dp_mask) == 0)
+            {
+                DlogPoint point{x, u, v};
+                if (!write_full(fd, &point, sizeof(point)))
+                    return; // координатор закончил
+                break;
+            }
+            walk.step(x, u, v);
+        }
     }
-
-    // Теперь U = (gcd, x, y)
-    return {u1, u2, u3};
+#endif
 }
 
-//* Случайная пара чисел (a, b) с условием min_a <= b <= a <= max_a
-std::pair<long long, long long> API egcd_generate_random_pair(long long min_a, long long max_a)
+long long dlog_coordinate(long long a, long long y, long long p, const std::vector<int> &fds)
 {
-    if (min_a < 1)
-        min_a = 1;
-    if (max_a <= min_a)
-        max_a = min_a + 1;
-
-    srand(time(0));
+#ifdef _WIN32
+    (void)a, (void)y, (void)p, (void)fds;
+    throw std::runtime_error("dlog_coordinate: not supported on this platform");
+#else
+    if (p < 3 || !(p & 1) || !is_probably_prime(p, 0))
+        throw std::invalid_argument("dlog_coordinate: p must be an odd prime");
+    a = ((a % p) + p) % p;
+    y = ((y % p) + p) % p;
+    if (a == 0 || y == 0)
+        return -1;
+    if (y == 1)
+        return 0;
+    const unsigned long long n = (unsigned long long)element_order(a, p);
+    if (mod_pow(y, (long long)n, p) != 1)
+        return -1;
 
-    long long a = min_a + (rand() % (max_a - min_a + 1));
-    long long b;
+    // ~sqrt(n) шагов на всех, выделенных точек из них ~ sqrt(n) / 2^dp_bits
+    DlogTask task{};
+    std::memcpy(task.magic, DLOG_TASK_MAGIC, sizeof(DLOG_TASK_MAGIC));
+    task.a = (unsigned long long)a;
+    task.y = (unsigned long long)y;
+    task.p = (unsigned long long)p;
+    task.n = n;
+    task.walk_seed = random_u64();
+    task.dp_bits = (unsigned long long)(64 - __builtin_clzll(n)) / 4;
 
-    if (a == min_a)
-        b = min_a;
-    else
-        b = min_a + (rand() % (a - min_a + 1));
+    std::vector<pollfd> pfds;
+    for (int fd : fds)
+    {
+        task.start_seed = random_u64();
+        if (write_full(fd, &task, sizeof(task)))
+            pfds.push_back({fd, POLLIN, 0});
+    }
 
-    return {a, b};
+    std::unordered_map<unsigned long long, std::pair<unsigned long long, unsigned long long>> points;
+    size_t alive = pfds.size();
+    while (alive > 0)
+    {
+        if (::poll(pfds.data(), pfds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("dlog_coordinate: poll failed");
+        }
+        for (auto &pfd : pfds)
+        {
+            if (pfd.fd < 0 || !pfd.revents)
+                continue;
+            DlogPoint point;
+            if (!read_full(pfd.fd, &point, sizeof(point)))
+            {
+                pfd.fd = -1; // рабочий отключился
+                --alive;
+                continue;
+            }
+            auto ins = points.emplace(point.x, std::make_pair(point.u, point.v));
+            if (ins.second || ins.first->second == std::make_pair(point.u, point.v))
+                continue;
+            long long res = rho_collision(a, y, p, n, point.u, point.v, ins.first->second.first, ins.first->second.second);
+            if (res >= 0)
+                return res;
+        }
+    }
+    return -1; // все рабочие отключились
+#endif
 }
 
-//* Генерация пары простых чисел в диапазоне [min_a, max_a]
-std::pair<long long, long long> API egcd_generate_prime_pair(long long min_a, long long max_a)
+long long dlog_distributed(long long a, long long y, long long p, int workers)
 {
-    if (min_a < 2)
-        min_a = 2;
-    if (max_a <= min_a)
-        max_a = min_a + 1000;
-
-    long long a = generate_prime(min_a, max_a);
+#ifdef _WIN32
+    (void)a, (void)y, (void)p, (void)workers;
+    throw std::runtime_error("dlog_distributed: not supported on this platform");
+#else
+    if (p < 3 || !(p & 1) || !is_probably_prime(p, 0))
+        throw std::invalid_argument("dlog_distributed: p must be an odd prime");
+    const unsigned long long nworkers = workers > 0 ? (unsigned long long)workers : hardware_threads();
 
-    long long b;
-    do
+    std::vector<int> fds;
+    std::vector<pid_t> pids;
+    auto stop = [&]()
     {
-        b = generate_prime(min_a, max_a);
-    } while (b == a);
+        for (int fd : fds)
+            ::close(fd);
+        for (pid_t pid : pids)
+        {
+            ::kill(pid, SIGTERM);
+            ::waitpid(pid, nullptr, 0);
+        }
+    };
+    for (unsigned long long w = 0; w < nworkers; ++w)
+    {
+        int sv[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        {
+            stop();
+            throw std::runtime_error("dlog_distributed: socketpair failed");
+        }
+        pid_t pid = ::fork();
+        if (pid < 0)
+        {
+            ::close(sv[0]);
+            ::close(sv[1]);
+            stop();
+            throw std::runtime_error("dlog_distributed: fork failed");
+        }
+        if (pid == 0)
+        {
+            // рабочий процесс: только свой конец соединения
+            ::close(sv[0]);
+            for (int fd : fds)
+                ::close(fd);
+            dlog_worker(sv[1]);
+            ::_exit(0);
+        }
+        ::close(sv[1]);
+        fds.push_back(sv[0]);
+        pids.push_back(pid);
+    }
 
-    return {a, b};
+    long long result;
+    try
+    {
+        result = dlog_coordinate(a, y, p, fds);
+    }
+    catch (...)
+    {
+        stop();
+        throw;
+    }
+    stop();
+    return result;
+#endif
 }
 
-long long API bsgs(long long a, long long y, long long p)
+long long dlog_kangaroo(long long a, long long y, long long p, long long lo, long long hi)
 {
-    long long m = (long long)ceil(sqrt(p));
-    std::unordered_map<long long, long long> baby_steps;
-
-    // Шаги младенца: y * a^j
-    for (long long j = 0; j < m; j++)
+    if (p < 3 || !(p & 1))
+        throw std::invalid_argument("dlog_kangaroo: p must be odd and > 2");
+    if (lo < 0 || hi < lo)
+        throw std::invalid_argument("dlog_kangaroo: expected 0 <= lo <= hi");
+    a = ((a % p) + p) % p;
+    y = ((y % p) + p) % p;
+    // порядок группы не больше p - 1: любое окно из p - 1 показателей содержит все решения
+    if (hi - lo >= p - 1)
+        hi = lo + p - 2;
+    const unsigned long long width = (unsigned long long)(hi - lo);
+    if (width < 64)
     {
-        long long value = (y * mod_pow(a, j, p)) % p;
-        baby_steps[value] = j;
+        // узкий интервал — прямой перебор
+        long long cur = mod_pow(a, lo, p);
+        for (long long x = lo; x <= hi; ++x, cur = (long long)((unsigned __int128)cur * a % p))
+            if (cur == y)
+                return x;
+        return -1;
     }
 
-    long long a_m = mod_pow(a, m, p);
+    // Прыжки 2^0..2^(k-1), средняя длина ~ sqrt(width) / 2; ручной кенгуру проходит
+    // ~4 средних прыжка на средний прыжок (путь ~ width) и ставит ловушку, дикий
+    // идёт от y, пока не догонит ловушку или не уйдёт за неё
+    unsigned k = 1;
+    const double mean_target = std::sqrt((double)width) / 2;
+    while (k < 62 && ((double)((1ULL << (k + 1)) - 1) / (k + 1)) <= mean_target)
+        ++k;
+    const unsigned long long mean = ((1ULL << k) - 1) / k;
+    const unsigned long long tame_steps = 4 * mean;
 
-    // Шаги великана: (a^m)^i
-    long long gamma = 1;
-    for (long long i = 0; i <= m; i++)
+    MontgomeryContext ctx((unsigned long long)p);
+    unsigned long long jump[64];
+    for (unsigned i = 0; i < k; ++i)
+        jump[i] = ctx.to_mont((unsigned long long)mod_pow(a, 1LL << i, p));
+
+    for (int attempt = 0; attempt < 8; ++attempt)
     {
-        if (baby_steps.count(gamma))
+        const unsigned long long salt = random_u64();
+
+        // ручной кенгуру: от a^hi, путь d_tame
+        unsigned long long tame = ctx.to_mont((unsigned long long)mod_pow(a, hi, p)), d_tame = 0;
+        for (unsigned long long i = 0; i < tame_steps; ++i)
         {
-            long long j = baby_steps[gamma];
-            long long x = i * m - j;
-            if (x >= 0)
-                return x % (p - 1);
+            unsigned j = walk_index(tame, salt, k);
+            tame = ctx.mul(tame, jump[j]);
+            d_tame += 1ULL << j;
         }
-        gamma = (gamma * a_m) % p;
-    }
 
-    return -1; // решение не найдено
+        // дикий кенгуру: от y = a^x; ловушка в точке hi + d_tame
+        unsigned long long wild = ctx.to_mont((unsigned long long)y), d_wild = 0;
+        while (d_wild <= width + d_tame)
+        {
+            if (wild == tame)
+            {
+                long long cand = (long long)((unsigned long long)hi + d_tame - d_wild);
+                if (mod_pow(a, cand, p) != y)
+                    break;
+                if (cand >= lo && cand <= hi)
+                    return cand;
+                // путь ручного обошёл весь цикл <a> (интервал шире порядка a): для простого p
+                // решения — cand по модулю порядка, наименьшее не меньше lo либо в интервале, либо его нет
+                if (!is_probably_prime(p, 0))
+                    break;
+                const long long order = element_order(a, p);
+                long long r = lo + ((cand - lo) % order + order) % order;
+                return r <= hi ? r : -1;
+            }
+            unsigned j = walk_index(wild, salt, k);
+            wild = ctx.mul(wild, jump[j]);
+            d_wild += 1ULL << j;
+        }
+    }
+    return -1;
 }
 
 //* Генерация параметров для задачи дискретного логарифма (BSGS)
@@ -344,13 +3667,9 @@ std::tuple<long long, long long, long long, long long> API bsgs_generate_random_
     if (max_p <= min_p)
         max_p = min_p + 100;
 
-    srand(time(0));
-
     long long p = generate_prime(min_p, max_p);
     long long a = find_generator(p);
-    long long x = 0;
-    if (p > 1)
-        x = rand() % (p - 1);
+    long long x = random_range(0, p - 2);
     long long y = mod_pow(a, x, p);
 
     return {a, y, p, x};
@@ -365,8 +3684,19 @@ long long dh_compute_shared(long long p, long long g, long long XA, long long XB
     if (XA <= 0 || XB <= 0)
         throw std::invalid_argument("dh_compute_shared: secrets must be positive");
 
-    long long YA = mod_pow(g, XA, p);
-    long long YB = mod_pow(g, XB, p);
+    // p > 2 простое в рабочих сценариях; для чётного p таблицу построить нельзя
+    long long YA, YB;
+    if (p & 1)
+    {
+        auto g_pow = cached_fixed_base(g, p);
+        YA = g_pow->pow(XA);
+        YB = g_pow->pow(XB);
+    }
+    else
+    {
+        YA = mod_pow(g, XA, p);
+        YB = mod_pow(g, XB, p);
+    }
 
     long long K1 = mod_pow(YB, XA, p); // на стороне A
     long long K2 = mod_pow(YA, XB, p); // на стороне B
@@ -383,40 +3713,39 @@ long long dh_compute_shared(long long p, long long g, long long XA, long long XB
 //* Возвращает (p, g, XA, XB)
 std::tuple<long long, long long, long long, long long> API dh_generate_random_params()
 {
-    srand(time(0));
-
     long long p = 0;
     long long q = 0;
 
     const long long MIN_Q = 500000;
     const long long RANGE_Q = 10000000;
 
-    while (true)
-    {
-        long long candidate_q = generate_prime(MIN_Q, RANGE_Q);
-        long long candidate_p = 2 * candidate_q + 1;
-        if (candidate_p <= 2)
-            continue;
+    long long g = 0;
 
-        if (is_probably_prime(candidate_p))
-        {
-            q = candidate_q;
-            p = candidate_p;
-            break;
-        }
+    // из пула безопасное простое берётся вместе с известной образующей
+    PrimePool *pool = PrimePool::from_env();
+    PrimePoolEntry entry;
+    if (pool && pool->take_in_range(2 * MIN_Q + 1, 2 * RANGE_Q + 1, true, entry))
+    {
+        p = entry.p;
+        q = (p - 1) / 2;
+        g = entry.g;
     }
 
-    long long g = 0;
+    if (p == 0)
+    {
+        p = generate_safe_prime(MIN_Q, RANGE_Q);
+        q = (p - 1) / 2;
+    }
 
-    while (true)
+    while (g == 0)
     {
-        g = 2 + (rand() % (p - 3));
-        if (mod_pow(g, q, p) != 1)
-            break;
+        long long cand = random_range(2, p - 2);
+        if (mod_pow(cand, q, p) != 1)
+            g = cand;
     }
 
-    long long XA = 2 + (rand() % (p - 3));
-    long long XB = 2 + (rand() % (p - 3));
+    long long XA = random_range(2, p - 2);
+    long long XB = random_range(2, p - 2);
 
     return {p, g, XA, XB};
 }
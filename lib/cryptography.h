@@ -1,5 +1,12 @@
 #pragma once
 #include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include "modint.h"
+#include "bigint.h"
 
 // Экспорт функций (для Windows нужно __declspec(dllexport/dllimport))
 #if defined(_WIN32) || defined(_WIN64)
@@ -12,16 +19,426 @@
 #define API
 #endif
 
+//* Контекст модуля для арифметики Монтгомери (R = 2^64).
+//* Строится один раз на модуль (например, на весь файл) и переиспользуется
+//* для всех умножений: деление заменяется двумя умножениями и сдвигом.
+//* Модуль должен быть нечётным и меньше 2^63.
+struct API MontgomeryContext
+{
+    unsigned long long n;     // модуль
+    unsigned long long n_neg; // -n^{-1} mod 2^64
+    unsigned long long r;     // R mod n (единица в форме Монтгомери)
+    unsigned long long r2;    // R^2 mod n (для перевода в форму Монтгомери)
+
+    explicit MontgomeryContext(unsigned long long mod);
+
+    // REDC: t * R^{-1} mod n, t < n * 2^64
+    unsigned long long reduce(unsigned __int128 t) const
+    {
+        unsigned long long m = (unsigned long long)t * n_neg;
+        unsigned __int128 s = (t + (unsigned __int128)m * n) >> 64;
+        unsigned long long res = (unsigned long long)s;
+        return res >= n ? res - n : res;
+    }
+    unsigned long long mul(unsigned long long a, unsigned long long b) const
+    {
+        return reduce((unsigned __int128)a * b);
+    }
+    unsigned long long sqr(unsigned long long a) const
+    {
+        return reduce((unsigned __int128)a * a);
+    }
+    unsigned long long to_mont(unsigned long long a) const
+    {
+        return mul(a % n, r2);
+    }
+    unsigned long long from_mont(unsigned long long a) const
+    {
+        return reduce(a);
+    }
+};
+
 long long API mod_pow(long long a, long long x, long long p);
+long long API mod_pow(long long a, long long x, const MontgomeryContext &ctx);
+//* Возведение в степень для модулей во всём 64-битном диапазоне (в т.ч. >= 2^63);
+//* ширина Монтгомери (32 или 64 бита) выбирается по размеру модуля
+unsigned long long API mod_pow_u64(unsigned long long a, unsigned long long x, unsigned long long p);
+
+//* Пакетное возведение в степень: out[i] = bases[i]^exp mod mod, i < n.
+//* Для нечётных модулей блоки обрабатываются параллельно в SIMD-регистрах
+//* (AVX2 / AVX-512 / AVX-512 IFMA, выбор по CPU во время выполнения).
+//* out может совпадать с bases.
+void API mod_pow_batch(const unsigned long long *bases, unsigned long long exp, unsigned long long mod,
+                       unsigned long long *out, size_t n);
+
+//* Шаг перекодированного показателя (скользящее окно, слева направо):
+//* возвести результат в квадрат squarings раз, затем умножить на base^digit
+//* (digit нечётная; 0 — только возведения в квадрат)
+struct ExpStep
+{
+    int squarings;
+    int digit;
+};
+
+//* Возведение многих оснований в одну фиксированную степень (m^d mod N для всех блоков файла).
+//* Показатель перекодируется в скользящие окна один раз; на каждое основание
+//* строятся только его нечётные степени base^1, base^3, ..., base^(2^w - 1).
+//* window_bits = 0 — ширина окна подбирается по длине показателя.
+class API FixedExpPow
+{
+public:
+    FixedExpPow(long long exp, long long mod, int window_bits = 0);
+
+    long long pow(long long base) const;
+    void pow_batch(const unsigned long long *bases, unsigned long long *out, size_t n) const;
+    const MontgomeryContext &context() const { return ctx; }
+
+private:
+    MontgomeryContext ctx;
+    int window;
+    std::vector<ExpStep> steps;
+};
+
+//* Произведение степеней b1^e1 * b2^e2 * ... mod mod за один общий ряд возведений
+//* в квадрат (метод Штрауса / трюк Шамира): multi_pow({{b1, e1}, {b2, e2}}, p)
+//* стоит примерно как одно возведение в степень, а не как два.
+long long API multi_pow(const std::vector<std::pair<long long, long long>> &terms, long long mod);
+
+//* Возведение фиксированного основания в степень (g^k mod p для многих k).
+//* Таблица строится один раз на пару (base, mod): для каждого окна из window_bits
+//* бит показателя хранятся base^(j * 2^(i*window_bits)), поэтому pow(k) — это
+//* одно умножение на окно, без возведений в квадрат. Модуль должен быть нечётным.
+class API FixedBasePow
+{
+public:
+    FixedBasePow(long long base, long long mod, int window_bits = 8);
+
+    long long pow(long long k) const;
+    const MontgomeryContext &context() const { return ctx; }
+
+private:
+    MontgomeryContext ctx;
+    int window;                            // ширина окна в битах
+    int windows;                           // число окон (покрывают битовую длину mod)
+    unsigned long long top;                // base^(2^(window*windows)) в форме Монтгомери
+    std::vector<unsigned long long> table; // table[i << window | j] = base^(j * 2^(i*window))
+};
+//* Точный для всех p < 2^63: детерминированный Миллер-Рабин в форме Монтгомери.
+//* k не используется — параметр прежнего вероятностного теста, оставлен только для
+//* совместимости вызовов
 bool API is_probably_prime(long long p, int k = 25);
 long long API generate_prime(long long low, long long high);
+//* Случайное безопасное простое p = 2q + 1 (q простое) с q из [q_low, q_high], q_high < 2^62.
+//* q и 2q + 1 просеиваются совместно, поиск идёт в threads потоках (0 — автоматически:
+//* по числу ядер для q_high >= 2^40, иначе один), первый результат останавливает остальные
+long long API generate_safe_prime(long long q_low, long long q_high, int threads = 0);
+//* Все простые из [lo, hi] по возрастанию: многопоточное сегментированное решето
+//* (threads = 0 — по числу ядер); выше 2^40 выжившие проверяются Миллером-Рабином
+std::vector<long long> API primes_in_range(long long lo, long long hi, int threads = 0);
+//* out[i] = is_probably_prime(values[i]) для массива: пробное деление, затем Миллер-Рабин
+//* по 8 модулей в дорожках AVX-512 IFMA (числа < 2^52); массив делится между потоками
+void API is_probably_prime_batch(const long long *values, size_t n, bool *out, int threads = 0);
+
+//* Запись пула: простое p и для безопасного p = 2q + 1 — образующая g (у обычных g = 0)
+struct PrimePoolEntry
+{
+    long long p;
+    long long g;
+};
+
+//* Пул заранее проверенных простых в файле, отображённом в память (mmap, MAP_SHARED):
+//* корзины по битовой длине p (POOL_MIN_BITS..POOL_MAX_BITS) отдельно для обычных и
+//* безопасных простых. Корзина — кольцо на capacity записей со счётчиками filled/taken:
+//* take забирает запись атомарно (CAS по taken, без блокировок, между процессами),
+//* refill дописывает под flock файла <path>.lock — открытие и take пополнения не ждут.
+//* Открытие — O(1): файл не читается целиком.
+//* Если задана переменная окружения CRYPTO_PRIME_POOL, generate_prime, generate_safe_prime
+//* и dh_generate_random_params сначала берут число из этого пула (см. take_in_range).
+//* Файл пула — секретные данные: из него берутся P, Q ключей RSA и p Эль-Гамаля. Он и
+//* <path>.lock создаются с правами 0600, выданное простое стирается из слота (take)
+class API PrimePool
+{
+public:
+    static constexpr int POOL_MIN_BITS = 8;
+    static constexpr int POOL_MAX_BITS = 62;
+
+    //* Открывает файл пула; если его нет и capacity > 0 — создаёт пустой на capacity записей в корзине
+    explicit PrimePool(const std::string &path, size_t capacity = 0);
+    ~PrimePool();
+    PrimePool(const PrimePool &) = delete;
+    PrimePool &operator=(const PrimePool &) = delete;
+
+    //* Запись из корзины bits; false — корзина пуста
+    bool take(int bits, bool safe, PrimePoolEntry &out);
+    //* Запись с p из [lo, hi]: корзина выбирается случайно среди целиком лежащих в диапазоне
+    //* с весом по числу кандидатов (как равномерный выбор из их объединения), пустые пропускаются
+    bool take_in_range(long long lo, long long hi, bool safe, PrimePoolEntry &out);
+    size_t available(int bits, bool safe) const;
+    size_t capacity() const;
+    //* Дополняет корзины min_bits..max_bits до заполнения; возвращает число новых записей
+    size_t refill(int min_bits = POOL_MIN_BITS, int max_bits = POOL_MAX_BITS);
+
+    //* Пул из CRYPTO_PRIME_POOL (открывается один раз) или nullptr
+    static PrimePool *from_env();
+
+private:
+    struct Bucket;
+    Bucket *bucket(int bits, bool safe) const;
+    unsigned long long *slots(int bits, bool safe) const;
+
+    std::string lock_path;
+    int fd = -1;
+    size_t size = 0;
+    unsigned char *base = nullptr;
+};
+
+//* Генератор случайных чисел библиотеки: поток ChaCha20 (ключ 256 бит, 64-битный счётчик
+//* блоков и номер потока). Выход вырабатывается сразу BUFFER_WORDS словами (64 блока ChaCha);
+//* после каждого заполнения первые 4 слова буфера становятся новым ключом — по состоянию
+//* генератора прошлый выход не восстановить. Подходит для std::uniform_int_distribution.
+//* Экземпляр не потокобезопасен: у каждого потока свой (crypto_rng())
+class API CryptoRng
+{
+public:
+    using result_type = unsigned long long;
+    static const size_t BUFFER_WORDS = 512;
+
+    //* Ключ из std::random_device
+    CryptoRng();
+    //* Детерминированный поток: одинаковые (seed, stream) — одинаковый выход
+    CryptoRng(unsigned long long seed, unsigned long long stream);
+
+    void reseed(unsigned long long seed, unsigned long long stream);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~0ULL; }
+    result_type operator()()
+    {
+        if (pos == BUFFER_WORDS)
+            refill();
+        return buf[pos++];
+    }
+    //* n слов подряд — тот же поток, что и n вызовов operator()
+    void fill(unsigned long long *out, size_t n);
+
+private:
+    void refill();
+
+    uint32_t key[8];
+    unsigned long long counter = 0, stream = 0;
+    unsigned long long buf[BUFFER_WORDS];
+    size_t pos = BUFFER_WORDS;
+};
+
+//* Генератор текущего потока (создаётся при первом обращении)
+CryptoRng API &crypto_rng();
+//* Воспроизводимые запуски (замеры): генератор вызывающего потока переключается на
+//* поток 0 от seed, потоки, впервые обратившиеся к crypto_rng() после вызова, получают
+//* номера 1, 2, ... в порядке обращения. Воспроизводимы только однопоточные запуски:
+//* рабочие потоки библиотеки берут зёрна из генератора вызывающего потока, но при
+//* threads > 1 результат (например, generate_safe_prime) зависит от того,
+//* какой поток первым найдёт ответ
+void API random_seed(unsigned long long seed);
+
+//* Малые простые 2..997 (пробное деление) и случайные слова из генератора потока
+extern API const int SMALL_PRIMES_ARR[];
+extern API const int SMALL_PRIMES_COUNT;
+unsigned long long API random_u64();
+void API random_u64(unsigned long long *out, size_t n);
+
+//* Тест Миллера-Рабина для длинных чисел (k случайных оснований);
+//* перед ним — пробное деление: остаток по произведению нескольких малых простых
+//* (одно длинное деление на группу), затем остатки по каждому простому группы
+template <size_t L>
+bool is_probably_prime(const BigUInt<L> &n, int k = 25)
+{
+    int bits = n.bit_length();
+    if (bits <= 62)
+        return is_probably_prime((long long)n.limb[0], k);
+    if (!n.is_odd())
+        return false;
+
+    for (int i = 1; i < SMALL_PRIMES_COUNT;)
+    {
+        unsigned long long prod = 1;
+        int j = i;
+        while (j < SMALL_PRIMES_COUNT && prod <= ~0ULL / (unsigned long long)SMALL_PRIMES_ARR[j])
+            prod *= (unsigned long long)SMALL_PRIMES_ARR[j++];
+        unsigned long long rem = n.mod_word(prod);
+        for (; i < j; ++i)
+            if (rem % (unsigned long long)SMALL_PRIMES_ARR[i] == 0)
+                return false;
+    }
+
+    // n - 1 = d * 2^s
+    BigUInt<L> n_minus_1 = n - BigUInt<L>(1);
+    BigUInt<L> d = n_minus_1;
+    int s = 0;
+    while (!d.bit(s))
+        ++s;
+    d >>= s;
+
+    BigMontgomery<L> ctx(n);
+    BigUInt<L> minus_one = ctx.sub(BigUInt<L>(), ctx.r); // -1 в форме Монтгомери
+    for (int round = 0; round < (k > 0 ? k : 25); ++round)
+    {
+        // основание 2 <= a < 2^(bits-1) < n - 1
+        BigUInt<L> a;
+        for (size_t i = 0; i < L; ++i)
+            a.limb[i] = random_u64();
+        a >>= BigUInt<L>::BITS - bits + 1;
+        if (a < BigUInt<L>(2))
+            a = BigUInt<L>(2);
+
+        BigUInt<L> x = ctx.to_mont(ctx.pow(a, d));
+        if (x == ctx.r || x == minus_one)
+            continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; ++r)
+        {
+            x = ctx.sqr(x);
+            if (x == minus_one)
+                composite = false;
+            else if (x == ctx.r)
+                break;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
+
+//* Случайное простое ровно из bits бит (два старших бита единичные — произведение
+//* двух таких простых имеет ровно 2*bits бит). Кандидаты перебираются с шагом 2
+//* от случайной точки. Остатки стартовой точки по малым простым считаются один раз
+//* (деление длинного числа на слово), для кандидата base + delta проверяется
+//* (остаток + delta) % простое — деление на машинных словах на каждое малое простое.
+//* Вызов: generate_prime<16>(512)
+template <size_t L>
+BigUInt<L> generate_prime(int bits)
+{
+    if (bits < 16 || bits > BigUInt<L>::BITS)
+        throw std::invalid_argument("generate_prime: bits out of range for this width");
+
+    std::vector<unsigned> residues(SMALL_PRIMES_COUNT);
+    const unsigned MAX_DELTA = 1u << 16;
+    while (true)
+    {
+        BigUInt<L> base;
+        for (size_t i = 0; i < L; ++i)
+            base.limb[i] = random_u64();
+        base >>= BigUInt<L>::BITS - bits;
+        base.set_bit(bits - 1);
+        base.set_bit(bits - 2);
+        base.limb[0] |= 1;
+
+        for (int i = 1; i < SMALL_PRIMES_COUNT; ++i)
+            residues[i] = (unsigned)base.mod_word((unsigned long long)SMALL_PRIMES_ARR[i]);
+
+        for (unsigned delta = 0; delta < MAX_DELTA; delta += 2)
+        {
+            bool divisible = false;
+            for (int i = 1; i < SMALL_PRIMES_COUNT && !divisible; ++i)
+                divisible = (residues[i] + delta) % (unsigned)SMALL_PRIMES_ARR[i] == 0;
+            if (divisible)
+                continue;
+            BigUInt<L> cand = base + BigUInt<L>(delta);
+            if (cand.bit_length() != bits)
+                break;
+            if (is_probably_prime(cand))
+                return cand;
+        }
+    }
+}
+//* Разложение 0 < n < 2^64 на простые множители: пары (простое, степень) по возрастанию.
+//* Малые простые снимаются пробным делением по таблице, остаток — ро-методом
+//* Полларда-Брента в форме Монтгомери
+std::vector<std::pair<unsigned long long, int>> API factor(unsigned long long n);
+//* Наименьшая образующая по модулю простого p; разложение p - 1 кэшируется на процесс
 long long API find_generator(long long p);
 
 std::tuple<long long, long long, long long> API egcd(long long a, long long b);
+//* Обратный элемент a^{-1} mod m (Евклид без второго коэффициента Безу);
+//* -1, если обратного нет (gcd(a, m) != 1)
+long long API mod_inverse(long long a, long long m);
+//* Обращение n элементов на месте по трюку Монтгомери: одно обращение и 3(n-1) умножений.
+//* Бросает std::runtime_error, если хотя бы один элемент необратим
+void API batch_inverse(unsigned long long *values, size_t n, unsigned long long p);
 std::pair<long long, long long> API egcd_generate_random_pair(long long min_a = 10, long long max_a = 99);
 std::pair<long long, long long> API egcd_generate_prime_pair(long long min_a = 10, long long max_a = 99);
 
+//* Для простого p с гладким порядком a автоматически переходит к dlog_pohlig_hellman
 long long API bsgs(long long a, long long y, long long p);
+//* BSGS в пределах memory_bytes под таблицу шагов младенца: m уменьшается до размера
+//* таблицы (8 байт на слот, заполнение до половины), шагов великана — ceil(p / m) + 1.
+//* Ключи хранятся 32-битными отпечатками, совпадения проверяются возведением в степень.
+//* huge_pages — таблица на больших страницах (если система их выделит)
+long long API bsgs_bounded(long long a, long long y, long long p, size_t memory_bytes, bool huge_pages = false);
+//* BSGS в threads потоках (0 — по числу ядер): шарды таблицы шагов младенца строятся
+//* параллельно, шаги великана раздаются потокам блоками; первый найденный x
+//* останавливает остальные. Для малых p — обычный bsgs в одном потоке
+long long API bsgs_parallel(long long a, long long y, long long p, int threads = 0);
+
+class BabyStepTable;
+
+//* Таблица дискретного логарифма для многих y при одних основании и модуле.
+//* Шаги младенца a^j (j < m) строятся один раз; solve(y) делает шаги великана
+//* y * a^(-m*i) до совпадения, x = i * m + j. Модуль нечётный, основание обратимо.
+//* save пишет таблицу в файл; конструктор от пути отображает его в память (mmap,
+//* только чтение) — другие процессы не строят таблицу заново
+class API DlogTable
+{
+public:
+    //* steps = 0 — ceil(sqrt(mod)) шагов младенца
+    DlogTable(long long base, long long mod, long long steps = 0);
+    explicit DlogTable(const std::string &path);
+    ~DlogTable();
+    DlogTable(const DlogTable &) = delete;
+    DlogTable &operator=(const DlogTable &) = delete;
+
+    //* x из [0, mod - 1) с base^x ≡ y (mod mod) или -1
+    long long solve(long long y) const;
+    //* out[i] = solve(ys[i]); до 8 запросов решаются вперемешку
+    void solve(const long long *ys, long long *out, size_t n) const;
+    void save(const std::string &path) const;
+
+    long long base() const { return a; }
+    long long modulus() const { return p; }
+    long long baby_steps() const { return m; }
+
+private:
+    long long a, p, m;
+    unsigned long long step; // a^(-m) в форме Монтгомери
+    std::unique_ptr<BabyStepTable> table;
+};
+
+//* Ро-метод Полларда для дискретного логарифма по простому p: O(1) памяти,
+//* ожидаемое время O(sqrt(порядок a)). Блуждание с 20 добавлениями, цикл — методом Брента.
+//* Результат — x из [0, порядок a) или -1, если y не лежит в <a>
+long long API dlog_rho(long long a, long long y, long long p);
+//* Распределённый ро-метод с выделенными точками (p простое). Координатор раздаёт
+//* рабочим общую функцию шага, рабочие шлют выделенные точки, координатор ищет среди
+//* них встречу блужданий. Обмен — сообщения фиксированного размера по потоковым
+//* дескрипторам (сокеты, в т.ч. TCP между узлами с одинаковым порядком байт).
+//*   dlog_coordinate — координатор по уже открытым соединениям fds (не закрывает их);
+//*   dlog_worker     — рабочий на соединении fd, возвращается, когда координатор закрыл его;
+//*   dlog_distributed — workers рабочих процессов (fork) на этой машине (0 — по числу ядер)
+long long API dlog_coordinate(long long a, long long y, long long p, const std::vector<int> &fds);
+void API dlog_worker(int fd);
+long long API dlog_distributed(long long a, long long y, long long p, int workers = 0);
+//* Метод кенгуру (лямбда-метод Полларда) для x из [lo, hi]: O(1) памяти,
+//* ожидаемое время O(sqrt(hi - lo)); p нечётный. -1 — решение в интервале не найдено
+long long API dlog_kangaroo(long long a, long long y, long long p, long long lo, long long hi);
+//* Метод Полига-Хеллмана по простому p: порядок a раскладывается (через разложение p - 1),
+//* логарифм ищется в каждой подгруппе порядка q^e (BSGS или ро-метод), остатки — по КТО.
+//* Результат — x из [0, порядок a) или -1, если y не лежит в <a>
+long long API dlog_pohlig_hellman(long long a, long long y, long long p);
+//* Индексное исчисление по простому p (выгодно для p ~ 2^60 с большим простым делителем
+//* q >= 2^40 у p - 1): логарифмы базы множителей (2 и простые < 4096) по модулю q ищутся
+//* по гладким соотношениям, собираемым в threads потоках (0 — по числу ядер), и кэшируются
+//* на процесс — следующие запросы по тому же p стоят одного спуска. Остальные делители
+//* p - 1 — методом Полига-Хеллмана. Результат — x из [0, порядок a) или -1
+long long API dlog_index_calculus(long long a, long long y, long long p, int threads = 0);
 std::tuple<long long, long long, long long, long long> API bsgs_generate_random_params(long long min_p = 50, long long max_p = 1000);
 
 long long API dh_compute_shared(long long p, long long g, long long XA, long long XB);
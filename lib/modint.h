@@ -0,0 +1,277 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+
+//* Арифметика по модулю с выбором ширины машинного слова (форма Монтгомери, R = 2^Width).
+//*   ModInt<32>  — модули < 2^32, произведения в 64 битах;
+//*   ModInt<64>  — модули < 2^64, произведения в 128 битах;
+//*   ModInt<128> — модули < 2^128, произведение собирается из четырёх 64x64 умножений.
+//* Модуль должен быть нечётным и больше 1.
+//*
+//* ModInt<W>                — модуль задаётся во время выполнения (ModInt<W>::set_mod, на поток);
+//* StaticModInt<W, Mod>     — модуль известен при компиляции, все константы constexpr.
+
+template <int Width>
+struct ModWord;
+
+template <>
+struct ModWord<32>
+{
+    using type = uint32_t;
+    using wide = uint64_t;
+    static constexpr void mul_wide(type a, type b, type &hi, type &lo)
+    {
+        uint64_t t = (uint64_t)a * b;
+        hi = (type)(t >> 32);
+        lo = (type)t;
+    }
+};
+
+template <>
+struct ModWord<64>
+{
+    using type = uint64_t;
+    using wide = unsigned __int128;
+    static constexpr void mul_wide(type a, type b, type &hi, type &lo)
+    {
+        unsigned __int128 t = (unsigned __int128)a * b;
+        hi = (type)(t >> 64);
+        lo = (type)t;
+    }
+};
+
+template <>
+struct ModWord<128>
+{
+    using type = unsigned __int128;
+    static constexpr void mul_wide(type a, type b, type &hi, type &lo)
+    {
+        uint64_t a0 = (uint64_t)a, a1 = (uint64_t)(a >> 64);
+        uint64_t b0 = (uint64_t)b, b1 = (uint64_t)(b >> 64);
+        type p00 = (type)a0 * b0;
+        type p01 = (type)a0 * b1;
+        type p10 = (type)a1 * b0;
+        type p11 = (type)a1 * b1;
+        // средняя часть < 3 * 2^64, переполнения нет
+        type mid = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+        lo = (mid << 64) | (uint64_t)p00;
+        hi = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+    }
+};
+
+//* Константы Монтгомери для модуля n: n^{-1} mod R, R mod n, R^2 mod n
+template <int Width>
+struct MontgomeryParams
+{
+    using word = typename ModWord<Width>::type;
+
+    word n = 0;
+    word n_inv = 0; // n^{-1} mod R
+    word r = 0;     // R mod n (единица в форме Монтгомери)
+    word r2 = 0;    // R^2 mod n
+
+    constexpr MontgomeryParams() = default;
+    constexpr explicit MontgomeryParams(word mod) : n(mod)
+    {
+        if (mod < 3 || (mod & 1) == 0)
+            throw std::invalid_argument("MontgomeryParams: mod must be odd and > 1");
+        // Ньютон: каждая итерация удваивает число верных бит (3 -> 6 -> ... -> 192)
+        word inv = mod;
+        for (int i = 0; i < 6; ++i)
+            inv *= 2 - mod * inv;
+        n_inv = inv;
+        r = (word)(0 - mod) % mod;
+        if constexpr (Width < 128)
+        {
+            using wide = typename ModWord<Width>::wide;
+            r2 = (word)((wide)r * r % mod);
+        }
+        else
+        {
+            // 256-битного деления нет: R^2 = R * 2^Width через Width удвоений по модулю
+            r2 = r;
+            for (int i = 0; i < Width; ++i)
+                r2 = add(r2, r2);
+        }
+    }
+
+    constexpr word add(word a, word b) const
+    {
+        word s = a + b;
+        return (s < a || s >= n) ? s - n : s;
+    }
+    constexpr word sub(word a, word b) const
+    {
+        return a >= b ? a - b : a - b + n;
+    }
+    // (hi:lo) * R^{-1} mod n при (hi:lo) < n * R:
+    // m = lo * n^{-1} обнуляет младшее слово, поэтому результат — разность старших слов
+    constexpr word reduce(word hi, word lo) const
+    {
+        word m = lo * n_inv;
+        word mh = 0, ml = 0;
+        ModWord<Width>::mul_wide(m, n, mh, ml);
+        return hi >= mh ? hi - mh : hi - mh + n;
+    }
+    constexpr word mul(word a, word b) const
+    {
+        word hi = 0, lo = 0;
+        ModWord<Width>::mul_wide(a, b, hi, lo);
+        return reduce(hi, lo);
+    }
+    constexpr word to_mont(word a) const { return mul(a % n, r2); }
+    constexpr word from_mont(word a) const { return reduce(0, a); }
+};
+
+//* Модуль, задаваемый во время выполнения (свой для каждого потока)
+template <int Width>
+struct DynamicModulus
+{
+    static MontgomeryParams<Width> &params()
+    {
+        static thread_local MontgomeryParams<Width> p;
+        return p;
+    }
+};
+
+//* Модуль — константа времени компиляции
+template <int Width, typename ModWord<Width>::type Mod>
+struct StaticModulus
+{
+    static constexpr MontgomeryParams<Width> value{Mod};
+    static constexpr const MontgomeryParams<Width> &params() { return value; }
+};
+
+template <int Width, class Modulus>
+class BasicModInt
+{
+public:
+    using word = typename ModWord<Width>::type;
+
+    constexpr BasicModInt() : v(0) {}
+    constexpr BasicModInt(word x) : v(P().to_mont(x)) {}
+
+    //* Только для ModInt<W>: задать модуль текущего потока
+    static void set_mod(word mod) { Modulus::params() = MontgomeryParams<Width>(mod); }
+    static constexpr word mod() { return P().n; }
+
+    static constexpr BasicModInt from_mont(word m)
+    {
+        BasicModInt x;
+        x.v = m;
+        return x;
+    }
+    constexpr word val() const { return P().from_mont(v); }
+    constexpr word mont() const { return v; }
+
+    constexpr BasicModInt &operator+=(const BasicModInt &o)
+    {
+        v = P().add(v, o.v);
+        return *this;
+    }
+    constexpr BasicModInt &operator-=(const BasicModInt &o)
+    {
+        v = P().sub(v, o.v);
+        return *this;
+    }
+    constexpr BasicModInt &operator*=(const BasicModInt &o)
+    {
+        v = P().mul(v, o.v);
+        return *this;
+    }
+    constexpr BasicModInt operator-() const { return from_mont(P().sub(0, v)); }
+    friend constexpr BasicModInt operator+(BasicModInt a, const BasicModInt &b) { return a += b; }
+    friend constexpr BasicModInt operator-(BasicModInt a, const BasicModInt &b) { return a -= b; }
+    friend constexpr BasicModInt operator*(BasicModInt a, const BasicModInt &b) { return a *= b; }
+    friend constexpr bool operator==(const BasicModInt &a, const BasicModInt &b) { return a.v == b.v; }
+    friend constexpr bool operator!=(const BasicModInt &a, const BasicModInt &b) { return a.v != b.v; }
+
+    template <class Exp>
+    constexpr BasicModInt pow(Exp e) const
+    {
+        word result = P().r;
+        word cur = v;
+        for (; e > 0; e >>= 1)
+        {
+            if (e & 1)
+                result = P().mul(result, cur);
+            cur = P().mul(cur, cur);
+        }
+        return from_mont(result);
+    }
+
+    //* Обратный элемент по малой теореме Ферма — только для простого модуля
+    constexpr BasicModInt inv() const { return pow(mod() - 2); }
+
+private:
+    word v; // значение в форме Монтгомери
+
+    static constexpr const MontgomeryParams<Width> &P() { return Modulus::params(); }
+};
+
+template <int Width>
+using ModInt = BasicModInt<Width, DynamicModulus<Width>>;
+
+template <int Width, typename ModWord<Width>::type Mod>
+using StaticModInt = BasicModInt<Width, StaticModulus<Width, Mod>>;
+
+//* Наименьшая ширина слова, в которую помещается модуль
+constexpr int modint_width_for(unsigned long long mod)
+{
+    return (mod >> 32) == 0 ? 32 : 64;
+}
+
+//* base^exp mod mod в заданной ширине слова (нечётный модуль);
+//* скользящее окно слева направо (до 4 бит), таблица нечётных степеней base^1..base^15
+template <int Width, class Exp>
+constexpr typename ModWord<Width>::type mod_pow_width(typename ModWord<Width>::type base, Exp exp,
+                                                      typename ModWord<Width>::type mod)
+{
+    using word = typename ModWord<Width>::type;
+    MontgomeryParams<Width> p(mod);
+
+    int bits = 0;
+    for (Exp t = exp; t > 0; t >>= 1)
+        ++bits;
+    if (bits == 0)
+        return 1;
+    const int W = bits <= 6 ? 1 : bits <= 24 ? 3 : 4;
+
+    word odd[8] = {};
+    odd[0] = p.to_mont(base);
+    if (W > 1)
+    {
+        word b2 = p.mul(odd[0], odd[0]);
+        for (int k = 1; k < (1 << (W - 1)); ++k)
+            odd[k] = p.mul(odd[k - 1], b2);
+    }
+
+    word result = p.r;
+    bool started = false;
+    for (int i = bits - 1; i >= 0;)
+    {
+        if (((exp >> i) & 1) == 0)
+        {
+            result = p.mul(result, result);
+            --i;
+            continue;
+        }
+        int j = i - W + 1 > 0 ? i - W + 1 : 0;
+        while (((exp >> j) & 1) == 0)
+            ++j;
+        int digit = (int)((exp >> j) & ((Exp(1) << (i - j + 1)) - 1));
+        if (started)
+        {
+            for (int k = j; k <= i; ++k)
+                result = p.mul(result, result);
+            result = p.mul(result, odd[digit >> 1]);
+        }
+        else
+        {
+            result = odd[digit >> 1];
+            started = true;
+        }
+        i = j - 1;
+    }
+    return p.from_mont(result);
+}
@@ -0,0 +1,98 @@
+#!/bin/bash
+
+# Скрипт для сборки и обслуживания пула заранее проверенных простых
+# (rsa, elgamal, shamir и vernam берут из него числа, если задан CRYPTO_PRIME_POOL)
+
+# === Директории ===
+SRC_DIR="src"
+LIB_DIR="lib"
+BUILD_DIR="build"
+POOL_FILE="${CRYPTO_PRIME_POOL:-$BUILD_DIR/primes.pool}"
+
+# === Компиляция ===
+compile() {
+    echo "Компиляция программы primepool..."
+
+    mkdir -p $BUILD_DIR
+
+    echo "[1/2] Компиляция библиотеки cryptography..."
+    g++ -fPIC -shared $LIB_DIR/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2 -pthread
+
+    echo "[2/2] Компиляция программы primepool..."
+    g++ $SRC_DIR/primepool.cpp -I$LIB_DIR -L$BUILD_DIR -lcryptography -o $BUILD_DIR/primepool -std=c++17 -Wall -O2 -pthread
+
+    if [ $? -eq 0 ]; then
+        echo "✅ Готово! Исполняемый файл: $BUILD_DIR/primepool"
+    else
+        echo "❌ Ошибка компиляции!"
+        exit 1
+    fi
+}
+
+# === Создание и заполнение пула ===
+init() {
+    pool="${1:-$POOL_FILE}"
+    echo "Создание пула: $pool"
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/primepool init "$pool" $2
+}
+
+# === Пополнение (однократно) ===
+refill() {
+    pool="${1:-$POOL_FILE}"
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/primepool refill "$pool"
+}
+
+# === Фоновое пополнение раз в interval секунд ===
+refill_bg() {
+    pool="${1:-$POOL_FILE}"
+    interval="${2:-60}"
+    LD_LIBRARY_PATH=$BUILD_DIR nohup $BUILD_DIR/primepool refill "$pool" 8 62 "$interval" > "$BUILD_DIR/primepool.log" 2>&1 &
+    echo "Фоновое пополнение запущено (PID $!), журнал: $BUILD_DIR/primepool.log"
+}
+
+# === Состояние пула ===
+stat() {
+    pool="${1:-$POOL_FILE}"
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/primepool stat "$pool"
+}
+
+# === Справка ===
+help() {
+    echo "Использование: $0 [команда]"
+    echo ""
+    echo "Команды:"
+    echo "  compile                     - компиляция программы primepool"
+    echo "  init [pool] [capacity]      - создать пул (capacity записей в корзине, по умолчанию 1024) и заполнить"
+    echo "  refill [pool]               - дополнить все корзины"
+    echo "  refill_bg [pool] [interval] - пополнять в фоне раз в interval секунд (по умолчанию 60)"
+    echo "  stat [pool]                 - число доступных записей по корзинам"
+    echo ""
+    echo "Пул по умолчанию: \$CRYPTO_PRIME_POOL или $BUILD_DIR/primes.pool"
+    echo ""
+    echo "Примеры:"
+    echo "  $0 compile"
+    echo "  $0 init build/primes.pool"
+    echo "  $0 refill_bg build/primes.pool 30"
+    echo "  CRYPTO_PRIME_POOL=build/primes.pool ./elgamal.sh genkeys keys.txt"
+}
+
+case "$1" in
+    "compile")
+        compile
+        ;;
+    "init")
+        init "$2" "$3"
+        ;;
+    "refill")
+        refill "$2"
+        ;;
+    "refill_bg")
+        refill_bg "$2" "$3"
+        ;;
+    "stat")
+        stat "$2"
+        ;;
+    *)
+        help
+        ;;
+esac
@@ -14,10 +14,10 @@ compile() {
     mkdir -p $BUILD_DIR
     
     echo "[1/2] Компиляция библиотеки cryptography..."
-    g++ -fPIC -shared $LIB_DIR/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2
+    g++ -fPIC -shared $LIB_DIR/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2 -pthread
     
     echo "[2/2] Компиляция программы rsa..."
-    g++ $SRC_DIR/rsa.cpp -I$LIB_DIR -L$BUILD_DIR -lcryptography -o $BUILD_DIR/rsa -std=c++17 -Wall -O2
+    g++ $SRC_DIR/rsa.cpp -I$LIB_DIR -L$BUILD_DIR -lcryptography -o $BUILD_DIR/rsa -std=c++17 -Wall -O2 -pthread
     
     if [ $? -eq 0 ]; then
         echo "✅ Готово! Исполняемый файл: $BUILD_DIR/rsa"
@@ -37,6 +37,15 @@ genkeys() {
     LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/rsa genkeys "$key_file" "$min_p" "$max_p"
 }
 
+# Генерация длинных ключей (N из bits бит, 256..4096)
+genkeys_big() {
+    key_file="${1:-$BUILD_DIR/rsa_keys_big.txt}"
+    bits="${2:-2048}"
+
+    echo "🔑 Генерация ключей RSA ($bits бит) в файл: $key_file"
+    LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/rsa genkeys_big "$key_file" "$bits"
+}
+
 # Шифрование (Алиса)
 encrypt() {
     echo "🔒 Шифрование файла..."
@@ -101,6 +110,7 @@ help() {
     echo "Команды:"
     echo "  compile                       - компиляция программы RSA"
     echo "  genkeys [file] [min] [max]    - генерация ключей (P,Q,d,c)"
+    echo "  genkeys_big [file] [bits]     - длинные ключи (N из bits бит, по умолчанию 2048)"
     echo "  encrypt input output key      - шифрование файла (использует публичный d)"
     echo "  decrypt input output key      - расшифрование файла (использует приватный c)"
     echo "  demo                          - быстрая демонстрация работы RSA"
@@ -123,6 +133,9 @@ case "$1" in
     "genkeys")
         genkeys "$2" "$3" "$4"
         ;;
+    "genkeys_big")
+        genkeys_big "$2" "$3"
+        ;;
     "encrypt")
         encrypt "$2" "$3" "$4"
         ;;
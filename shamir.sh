@@ -16,10 +16,10 @@ compile() {
     mkdir -p $BUILD_DIR
     
     echo "[1/2] Компиляция библиотеки..."
-    g++ -fPIC -shared $LIB_DIR/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2
+    g++ -fPIC -shared $LIB_DIR/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2 -pthread
     
     echo "[2/2] Компиляция исполняемого файла..."
-    g++ $SRC_DIR/shamir.cpp -I$LIB_DIR -L$BUILD_DIR -lcryptography -o $BUILD_DIR/shamir -std=c++17 -Wall -O2
+    g++ $SRC_DIR/shamir.cpp -I$LIB_DIR -L$BUILD_DIR -lcryptography -o $BUILD_DIR/shamir -std=c++17 -Wall -O2 -pthread
     
     if [ $? -eq 0 ]; then
         echo "Готово! Исполняемый файл: $BUILD_DIR/shamir"
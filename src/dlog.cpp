@@ -0,0 +1,137 @@
+#include "../lib/cryptography.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// --- Распределённый поиск дискретного логарифма (ро-метод с выделенными точками) ---
+// local — рабочие процессы на этой машине; serve/work — координатор и рабочие на разных узлах по TCP
+
+typedef long long ll;
+
+//* Координатор: ждёт workers подключений на порту port и решает y = a^x mod p
+static ll serve(int port, int workers, ll a, ll y, ll p)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::runtime_error("cannot create socket");
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, workers) != 0)
+    {
+        close(listener);
+        throw std::runtime_error("cannot listen on port " + std::to_string(port));
+    }
+
+    std::cout << "waiting for " << workers << " workers on port " << port << "..." << std::endl;
+    std::vector<int> fds;
+    while ((int)fds.size() < workers)
+    {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd >= 0)
+            fds.push_back(fd);
+    }
+    close(listener);
+
+    ll x = dlog_coordinate(a, y, p, fds);
+    for (int fd : fds)
+        close(fd);
+    return x;
+}
+
+//* Рабочий: подключается к координатору host:port и работает до его завершения
+static void work(const std::string &host, const std::string &port)
+{
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+        throw std::runtime_error("cannot resolve " + host);
+    int fd = -1;
+    for (addrinfo *ai = res; ai && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0)
+        throw std::runtime_error("cannot connect to " + host + ":" + port);
+    dlog_worker(fd);
+    close(fd);
+}
+
+static void print_result(ll x)
+{
+    if (x != -1)
+        std::cout << "x = " << x << "\n";
+    else
+        std::cout << "no solution\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage:\n  " << argv[0] << " local <a> <y> <p> [workers]\n"
+                  << "  " << argv[0] << " serve <port> <workers> <a> <y> <p>\n"
+                  << "  " << argv[0] << " work <host> <port>\n";
+        return 1;
+    }
+
+    std::string cmd = argv[1];
+    try
+    {
+        if (cmd == "local")
+        {
+            if (argc < 5)
+            {
+                std::cerr << "local: need a y p\n";
+                return 1;
+            }
+            int workers = (argc > 5) ? std::stoi(argv[5]) : 0;
+            print_result(dlog_distributed(std::stoll(argv[2]), std::stoll(argv[3]), std::stoll(argv[4]), workers));
+        }
+        else if (cmd == "serve")
+        {
+            if (argc < 7)
+            {
+                std::cerr << "serve: need port workers a y p\n";
+                return 1;
+            }
+            print_result(serve(std::stoi(argv[2]), std::stoi(argv[3]), std::stoll(argv[4]), std::stoll(argv[5]), std::stoll(argv[6])));
+        }
+        else if (cmd == "work")
+        {
+            if (argc < 4)
+            {
+                std::cerr << "work: need host port\n";
+                return 1;
+            }
+            work(argv[2], argv[3]);
+        }
+        else
+        {
+            std::cerr << "Unknown command\n";
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -6,7 +6,6 @@
 #include <stdexcept>
 #include <cstring>
 #include <random>
-#include <chrono>
 #include <tuple>
 #include <algorithm>
 
@@ -67,20 +66,13 @@ static int bytes_needed_for_value(ull x)
     return b ? b : 1;
 }
 
-// Глобальный RNG (инициализация по времени)
-static std::mt19937_64 &global_rng()
-{
-    static std::mt19937_64 rng((unsigned)std::chrono::high_resolution_clock::now().time_since_epoch().count());
-    return rng;
-}
-
 // Возвращает случайное число в диапазоне [lo, hi]
 static ull rand_range_ull(ull lo, ull hi)
 {
     if (lo > hi)
         std::swap(lo, hi);
     std::uniform_int_distribution<ull> dist(lo, hi);
-    return dist(global_rng());
+    return dist(crypto_rng());
 }
 
 // Безопасное умножение по модулю с использованием 128-битного промежуточного результата
@@ -120,29 +112,14 @@ static std::tuple<ull, ull, ull, ull> load_keyfile(const std::string &path)
 // Генерация ключей Эль-Гамаля: генерируется простое p, ищется g, генерируется секретный c, вычисляется d = g^c mod p
 void generate_elgamal_keys(const std::string &key_file, ll min_prime, ll max_prime)
 {
-    ll p = 0;
-    ll q = 0;
-
-    while (true)
-    {
-        ll candidate_q = generate_prime(min_prime, max_prime);
-        ll candidate_p = 2 * candidate_q + 1;
-        if (candidate_p <= 2)
-            continue;
-
-        if (is_probably_prime(candidate_p))
-        {
-            q = candidate_q;
-            p = candidate_p;
-            break;
-        }
-    }
-
+    // q из [min_prime, max_prime] простое, p = 2q + 1 тоже простое
+    ll p = generate_safe_prime(min_prime, max_prime);
+    ll q = (p - 1) / 2;
     ll g = 0;
 
     while (true)
     {
-        g = 2 + (rand() % (p - 3));
+        g = (ll)rand_range_ull(2, (ull)p - 2);
         if (mod_pow(g, q, p) != 1)
             break;
     }
@@ -192,6 +169,11 @@ void elgamal_encrypt(const std::string &input_file, const std::string &output_fi
     fin.seekg(0, std::ios::beg);
     write_le64(fout, orig_size);
 
+    // g и d фиксированы на весь файл: таблицы их степеней строятся один раз,
+    // дальше g^k и d^k для каждого блока — по одному умножению на окно показателя
+    FixedBasePow g_pow((ll)g, (ll)p);
+    FixedBasePow d_pow((ll)d, (ll)p);
+
     // Чтение и шифрование блоков
     std::vector<unsigned char> inbuf(plain_block);
     while (true)
@@ -209,9 +191,9 @@ void elgamal_encrypt(const std::string &input_file, const std::string &output_fi
             throw std::runtime_error("Message block too large for p");
 
         ull k = rand_range_ull(1, p - 2);
-        ull r = (ull)mod_pow((ll)g, (ll)k, (ll)p); // r = g^k mod p
-        ull s = (ull)mod_pow((ll)d, (ll)k, (ll)p); // s = mod_pow(d, k, p);
-        ull e = modmul_u128(m, s, p);              // e = (m * s) mod p
+        ull r = (ull)g_pow.pow((ll)k); // r = g^k mod p
+        ull s = (ull)d_pow.pow((ll)k); // s = d^k mod p
+        ull e = modmul_u128(m, s, p);            // e = (m * s) mod p
 
         // Записываем в файл r (8 байт LE) и e (cipher_block байт BE)
         write_le64(fout, r);
@@ -244,48 +226,61 @@ void elgamal_decrypt(const std::string &input_file, const std::string &output_fi
     if (p_from_file != p)
         throw std::runtime_error("Prime p mismatch between key and cipher file");
 
-    // Читаем и расшифровываем блоки
+    // Читаем и расшифровываем блоки пачками по BATCH: s = r^c считается одним pow_batch,
+    // закрытый показатель c перекодируется один раз на файл
+    FixedExpPow s_pow((ll)c_private, (ll)p);
+    const size_t BATCH = 4096;
     std::vector<unsigned char> ebuf(cipher_block);
+    std::vector<ull> rs, es;
+    rs.reserve(BATCH);
+    es.reserve(BATCH);
     ull written = 0;
-    while (true)
+    bool eof = false;
+    while (!eof && written < orig_size)
     {
-        ull r;
-        try
+        rs.clear();
+        es.clear();
+        while (rs.size() < BATCH)
         {
-            r = read_le64(fin);
+            ull r;
+            try
+            {
+                r = read_le64(fin);
+            }
+            catch (...)
+            {
+                eof = true;
+                break;
+            }
+            fin.read(reinterpret_cast<char *>(ebuf.data()), cipher_block);
+            if (fin.gcount() != cipher_block)
+                throw std::runtime_error("Incomplete cipher block");
+            rs.push_back(r);
+            es.push_back(bytes_to_ull(ebuf));
         }
-        catch (...)
+
+        // s = r^c mod p, затем s^{-1} — одно обращение на всю пачку (на месте rs)
+        s_pow.pow_batch(rs.data(), rs.data(), rs.size());
+        try
         {
-            break;
+            batch_inverse(rs.data(), rs.size(), p);
         }
-        fin.read(reinterpret_cast<char *>(ebuf.data()), cipher_block);
-        if (fin.gcount() != cipher_block)
-            throw std::runtime_error("Incomplete cipher block");
-
-        ull e = bytes_to_ull(ebuf);
-        ull s = (ull)mod_pow((ll)r, (ll)c_private, (ll)p); // s = r^c mod p
-
-        // Находим s_inv по модулю p через расширенный алгоритм Евклида
-        auto eg = egcd((ll)s, (ll)p);
-        ll g = std::get<0>(eg);
-        ll x = std::get<1>(eg);
-        if (g != 1)
+        catch (const std::runtime_error &)
+        {
             throw std::runtime_error("No modular inverse for s (gcd != 1)");
-        ll inv = x % (ll)p;
-        if (inv < 0)
-            inv += (ll)p;
-        ull s_inv = (ull)inv;
-
-        ull m = modmul_u128(e, s_inv, p); // m = (e * s_inv) mod p
-
-        // Записываем в файл (учитываем оригинальный размер — обрезаем нули в конце)
-        auto outb = ull_to_bytes(m, (size_t)plain_block);
-        ull remain = orig_size - written;
-        size_t towrite = (size_t)std::min<ull>((ull)plain_block, remain);
-        fout.write(reinterpret_cast<const char *>(outb.data()), (std::streamsize)towrite);
-        written += towrite;
-        if (written >= orig_size)
-            break;
+        }
+
+        for (size_t i = 0; i < rs.size() && written < orig_size; ++i)
+        {
+            ull m = modmul_u128(es[i], rs[i], p); // m = (e * s_inv) mod p
+
+            // Записываем в файл (учитываем оригинальный размер — обрезаем нули в конце)
+            auto outb = ull_to_bytes(m, (size_t)plain_block);
+            ull remain = orig_size - written;
+            size_t towrite = (size_t)std::min<ull>((ull)plain_block, remain);
+            fout.write(reinterpret_cast<const char *>(outb.data()), (std::streamsize)towrite);
+            written += towrite;
+        }
     }
 }
 
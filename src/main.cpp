@@ -3,6 +3,7 @@
 #include <ctime>
 #include <limits>
 #include <vector>
+#include <stdexcept>
 #include "../lib/cryptography.h"
 
 using namespace std;
@@ -15,10 +16,49 @@ void waitForAnyKey()
     cin.get();                                           // Ждем нажатия клавиши
 }
 
-int main()
+//* Выбор метода поиска дискретного логарифма (y = a^x mod p)
+long long solveDiscreteLog(long long a, long long y, long long p)
 {
-    srand(time(0));
+    int method;
+    cout << "\nВыберите метод:" << endl;
+    cout << "1 - Шаг младенца, шаг великана (BSGS)" << endl;
+    cout << "2 - Ро-метод Полларда (p простое)" << endl;
+    cout << "3 - Метод кенгуру (x в известном интервале)" << endl;
+    cout << "4 - Метод Полига-Хеллмана (p простое)" << endl;
+    cout << "5 - Индексное исчисление (p простое)" << endl;
+    cout << "Ваш выбор: ";
+    cin >> method;
+
+    try
+    {
+        switch (method)
+        {
+        case 2:
+            return dlog_rho(a, y, p);
+        case 3:
+        {
+            long long lo, hi;
+            cout << "Введите границы интервала lo, hi: ";
+            cin >> lo >> hi;
+            return dlog_kangaroo(a, y, p, lo, hi);
+        }
+        case 4:
+            return dlog_pohlig_hellman(a, y, p);
+        case 5:
+            return dlog_index_calculus(a, y, p);
+        default:
+            return bsgs(a, y, p);
+        }
+    }
+    catch (const exception &e)
+    {
+        cout << "Ошибка: " << e.what() << endl;
+        return -1;
+    }
+}
 
+int main()
+{
     long long a, b, c;
     int choice;
     int subchoice;
@@ -138,7 +178,7 @@ int main()
             {
                 cout << "\nВведите a, y, p (y = a^x mod p): ";
                 cin >> a >> b >> c;
-                long long x = bsgs(a, b, c);
+                long long x = solveDiscreteLog(a, b, c);
                 if (x != -1)
                     cout << "Решение: x = " << x << endl;
                 else
@@ -152,7 +192,7 @@ int main()
             {
                 auto [a, y, p, secret_x] = bsgs_generate_random_params(50, 1000);
                 cout << "\nСгенерированы числа: a = " << a << ", y = " << y << ", p = " << p << endl;
-                long long solved = bsgs(a, y, p);
+                long long solved = solveDiscreteLog(a, y, p);
                 if (solved != -1)
                     cout << "Решение: x = " << solved << endl;
                 else
@@ -0,0 +1,78 @@
+#include "../lib/cryptography.h"
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <chrono>
+#include <thread>
+
+// --- Пул заранее проверенных простых: создание, пополнение, состояние ---
+// Программы библиотеки берут числа из пула, если путь к нему задан в CRYPTO_PRIME_POOL
+
+static void print_stat(PrimePool &pool)
+{
+    std::cout << "capacity per bucket: " << pool.capacity() << "\n"
+              << "bits   primes   safe\n";
+    for (int bits = PrimePool::POOL_MIN_BITS; bits <= PrimePool::POOL_MAX_BITS; ++bits)
+        std::cout << (bits < 10 ? " " : "") << bits << "   " << pool.available(bits, false) << "   "
+                  << pool.available(bits, true) << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage:\n  " << argv[0] << " init <pool_file> [capacity]\n"
+                  << "  " << argv[0] << " refill <pool_file> [min_bits] [max_bits] [interval_sec]\n"
+                  << "  " << argv[0] << " stat <pool_file>\n";
+        return 1;
+    }
+
+    std::string cmd = argv[1];
+    std::string path = argv[2];
+    try
+    {
+        if (cmd == "init")
+        {
+            size_t capacity = (argc > 3) ? (size_t)std::stoull(argv[3]) : 1024;
+            if (capacity == 0)
+            {
+                std::cerr << "init: capacity must be > 0\n";
+                return 1;
+            }
+            PrimePool pool(path, capacity);
+            size_t added = pool.refill();
+            std::cout << "pool " << path << " ready, added " << added << " entries\n";
+        }
+        else if (cmd == "refill")
+        {
+            int min_bits = (argc > 3) ? std::stoi(argv[3]) : PrimePool::POOL_MIN_BITS;
+            int max_bits = (argc > 4) ? std::stoi(argv[4]) : PrimePool::POOL_MAX_BITS;
+            int interval = (argc > 5) ? std::stoi(argv[5]) : 0;
+            PrimePool pool(path);
+            // interval > 0 — фоновое пополнение: корзины дополняются раз в interval секунд
+            do
+            {
+                size_t added = pool.refill(min_bits, max_bits);
+                std::cout << "added " << added << " entries" << std::endl;
+                if (interval > 0)
+                    std::this_thread::sleep_for(std::chrono::seconds(interval));
+            } while (interval > 0);
+        }
+        else if (cmd == "stat")
+        {
+            PrimePool pool(path);
+            print_stat(pool);
+        }
+        else
+        {
+            std::cerr << "Unknown command\n";
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -51,16 +51,12 @@ static int bytes_needed(ull x)
     return c ? c : 1;
 }
 
-// --------------------- вспомогательная функция: обратный элемент (через egcd) ---------------------
-static ull modinv_via_egcd(ull a, ull mod)
+// --------------------- вспомогательная функция: обратный элемент (mod_inverse) ---------------------
+static ull modinv(ull a, ull mod)
 {
-    auto t = egcd((long long)a, (long long)mod); // возвращает (g, x, y): a*x + mod*y = g
-    long long g = get<0>(t), x = get<1>(t);
-    if (g != 1)
-        throw runtime_error("modinv_via_egcd: inverse does not exist (g != 1)");
-    long long r = x % (long long)mod;
+    long long r = mod_inverse((long long)a, (long long)mod);
     if (r < 0)
-        r += (long long)mod;
+        throw runtime_error("modinv: inverse does not exist (g != 1)");
     return (ull)r;
 }
 
@@ -123,11 +119,10 @@ static void generate_rsa_keys(const string &key_file, long long min_prime = 1000
 
     // Выбираем d: публичный экспонент (1 < d < phi, gcd(d, phi) == 1)
     ll d = 0;
-    std::mt19937_64 rng((unsigned)chrono::high_resolution_clock::now().time_since_epoch().count());
     std::uniform_int_distribution<ull> dist(3ULL, phi > 3 ? phi - 1 : 3ULL);
     for (int i = 0; i < 1000 && d == 0; ++i)
     {
-        ull cand = dist(rng);
+        ull cand = dist(crypto_rng());
         if (std::gcd(cand, phi) == 1)
             d = (ll)cand;
     }
@@ -135,7 +130,7 @@ static void generate_rsa_keys(const string &key_file, long long min_prime = 1000
         throw runtime_error("generate_rsa_keys: failed to choose d");
 
     // Вычисляем c = d^{-1} mod phi (закрытый ключ)
-    ull c = modinv_via_egcd((ull)d, phi);
+    ull c = modinv((ull)d, phi);
 
     // Сохраняем (P,Q,d,c). P,Q — секрет Боба; d и N — публичные.
     save_keyfile(key_file, P, Q, d, (ll)c);
@@ -186,26 +181,41 @@ static void rsa_encrypt(const string &input_file, const string &output_file, ull
     fin.seekg(0, ios::beg);
     write_le64(fout, orig_size);
 
-    // Поблочное шифрование
+    // Поблочное шифрование: показатель d перекодируется один раз на файл,
+    // блоки копятся пачками по BATCH и возводятся в степень одним вызовом
+    FixedExpPow enc(d, (ll)N);
+    const size_t BATCH = 4096;
     vector<unsigned char> buf(plain_block);
-    while (true)
+    vector<ull> blocks;
+    blocks.reserve(BATCH);
+    bool eof = false;
+    while (!eof)
     {
-        fin.read(reinterpret_cast<char *>(buf.data()), (streamsize)plain_block);
-        streamsize got = fin.gcount();
-        if (got <= 0)
-            break;
-        if ((size_t)got < plain_block)
-            fill(buf.begin() + got, buf.end(), 0);
-        ull m = be_to_ull(buf);
-        if (m >= N)
-            throw runtime_error("rsa_encrypt: message block >= N (increase key size)");
+        blocks.clear();
+        while (blocks.size() < BATCH)
+        {
+            fin.read(reinterpret_cast<char *>(buf.data()), (streamsize)plain_block);
+            streamsize got = fin.gcount();
+            if (got <= 0)
+            {
+                eof = true;
+                break;
+            }
+            if ((size_t)got < plain_block)
+                fill(buf.begin() + got, buf.end(), 0);
+            ull m = be_to_ull(buf);
+            if (m >= N)
+                throw runtime_error("rsa_encrypt: message block >= N (increase key size)");
+            blocks.push_back(m);
+        }
+
         // e = m^d mod N
-        long long m_ll = (long long)m;
-        long long N_ll = (long long)N;
-        long long e_ll = mod_pow(m_ll, d, N_ll);
-        ull e = (ull)e_ll;
-        auto ebytes = ull_to_be(e, cipher_block);
-        fout.write(reinterpret_cast<const char *>(ebytes.data()), (streamsize)ebytes.size());
+        enc.pow_batch(blocks.data(), blocks.data(), blocks.size());
+        for (ull e : blocks)
+        {
+            auto ebytes = ull_to_be(e, cipher_block);
+            fout.write(reinterpret_cast<const char *>(ebytes.data()), (streamsize)ebytes.size());
+        }
     }
 }
 
@@ -238,38 +248,302 @@ static void rsa_decrypt(const string &input_file, const string &output_file, ull
     if (N_from_file != N)
         throw runtime_error("rsa_decrypt: modulus N mismatch");
 
+    // Закрытый показатель c один на весь файл
+    FixedExpPow dec(c, (ll)N);
+    const size_t BATCH = 4096;
     vector<unsigned char> cbuf(cipher_block);
+    vector<ull> blocks;
+    blocks.reserve(BATCH);
     ull written = 0;
+    bool eof = false;
+    while (!eof && written < orig_size)
+    {
+        blocks.clear();
+        while (blocks.size() < BATCH)
+        {
+            fin.read(reinterpret_cast<char *>(cbuf.data()), cipher_block);
+            streamsize got = fin.gcount();
+            if (got == 0)
+            {
+                eof = true;
+                break;
+            }
+            if (got != cipher_block)
+                throw runtime_error("rsa_decrypt: incomplete cipher block");
+            blocks.push_back(be_to_ull(cbuf));
+        }
+
+        // m = e_cipher^c mod N
+        dec.pow_batch(blocks.data(), blocks.data(), blocks.size());
+        for (ull m : blocks)
+        {
+            auto outb = ull_to_be(m, (size_t)plain_block);
+            ull remain = orig_size - written;
+            size_t towrite = (size_t)min<ull>((ull)plain_block, remain);
+            fout.write(reinterpret_cast<const char *>(outb.data()), (streamsize)towrite);
+            written += towrite;
+            if (written >= orig_size)
+                break;
+        }
+    }
+}
+
+// --------------------- длинные ключи (256..4096 бит) ---------------------
+// Формат key_file (текстовый, числа в hex):
+//   RSA-BIG <bits>
+//   P
+//   Q
+//   d (public key)
+//   c (private key)
+//
+// Формат шифртекста:
+//   [magic "RSA2"(4)] [plain_block (2 LE)] [cipher_block (2 LE)] [orig_size (8 LE)] [N (cipher_block, BE)]
+//   затем cipher_block байт (big-endian) на каждый блок.
+// Блок открытого текста — сотни байт (например, 255 для 2048-битного N), поэтому на мегабайт
+// приходится в ~35 раз меньше возведений в степень и заголовков блоков, чем при 64-битном N.
+
+static const ull BIG_PUBLIC_EXP = 65537;
+
+static bool is_big_keyfile(const string &path)
+{
+    ifstream f(path);
+    string tag;
+    return (f >> tag) && tag == "RSA-BIG";
+}
+
+struct BigKeyText
+{
+    int bits;
+    string P, Q, d, c;
+};
+
+static BigKeyText load_big_keyfile(const string &path)
+{
+    ifstream f(path);
+    if (!f)
+        throw runtime_error("Cannot open key file");
+    BigKeyText k;
+    string tag;
+    f >> tag >> k.bits >> k.P >> k.Q >> k.d >> k.c;
+    if (!f || tag != "RSA-BIG")
+        throw runtime_error("Bad key file format");
+    return k;
+}
+
+// x^{-1} mod m для малого x (открытой экспоненты): m = q*x + r, k = -r^{-1} mod x,
+// тогда k*m + 1 делится на x и (k*m + 1) / x = k*q + (k*r + 1) / x — без длинного деления
+template <size_t L>
+static BigUInt<L> inverse_small(ull x, const BigUInt<L> &m)
+{
+    BigUInt<L> q = m;
+    ull r = q.div_word(x);
+    long long r_inv = mod_inverse((long long)r, (long long)x);
+    if (r_inv < 0)
+        throw runtime_error("inverse_small: inverse does not exist");
+    ull k = (x - (ull)r_inv) % x;
+    q.mul_word(k);
+    return q + BigUInt<L>((k * r + 1) / x);
+}
+
+// Генерация: P, Q по bits/2 бит (два старших бита единичные — N ровно bits бит), d = 65537
+template <size_t L>
+static void generate_rsa_keys_big_impl(const string &key_file, int bits)
+{
+    constexpr size_t H = L / 2;
+    BigUInt<H> P, Q;
+    do
+        P = generate_prime<H>(bits / 2);
+    while (P.mod_word(BIG_PUBLIC_EXP) == 1);
+    do
+        Q = generate_prime<H>(bits / 2);
+    while (Q == P || Q.mod_word(BIG_PUBLIC_EXP) == 1);
+
+    BigUInt<L> phi = mul_full(P - BigUInt<H>(1), Q - BigUInt<H>(1));
+    BigUInt<L> c = inverse_small(BIG_PUBLIC_EXP, phi);
+
+    ofstream f(key_file);
+    if (!f)
+        throw runtime_error("Cannot write key file");
+    f << "RSA-BIG " << bits << "\n"
+      << P.to_hex() << "\n"
+      << Q.to_hex() << "\n"
+      << BigUInt<L>(BIG_PUBLIC_EXP).to_hex() << "\n"
+      << c.to_hex() << "\n";
+
+    cerr << "Generated RSA params (Bob): " << bits << "-bit N, d=" << BIG_PUBLIC_EXP << "\n";
+}
+
+template <size_t L>
+static void rsa_encrypt_big_impl(const string &input_file, const string &output_file, const BigKeyText &key)
+{
+    constexpr size_t H = L / 2;
+    BigUInt<L> N = mul_full(BigUInt<H>::from_hex(key.P), BigUInt<H>::from_hex(key.Q));
+    BigUInt<L> d = BigUInt<L>::from_hex(key.d);
+
+    ifstream fin(input_file, ios::binary);
+    ofstream fout(output_file, ios::binary);
+    if (!fin)
+        throw runtime_error("rsa_encrypt: cannot open input");
+    if (!fout)
+        throw runtime_error("rsa_encrypt: cannot open output");
+
+    int Nbits = N.bit_length();
+    size_t plain_block = max<size_t>(1, (Nbits - 1) / 8);
+    size_t cipher_block = (Nbits + 7) / 8;
+
+    fin.seekg(0, ios::end);
+    ull orig_size = (ull)fin.tellg();
+    fin.seekg(0, ios::beg);
+
+    fout.write("RSA2", 4);
+    fout.put(static_cast<char>(plain_block & 0xFF));
+    fout.put(static_cast<char>(plain_block >> 8));
+    fout.put(static_cast<char>(cipher_block & 0xFF));
+    fout.put(static_cast<char>(cipher_block >> 8));
+    write_le64(fout, orig_size);
+    vector<unsigned char> cbuf(cipher_block);
+    N.to_bytes(cbuf.data(), cipher_block);
+    fout.write(reinterpret_cast<const char *>(cbuf.data()), (streamsize)cipher_block);
+
+    // Контекст Монтгомери для N строится один раз на файл
+    BigMontgomery<L> ctx(N);
+    vector<unsigned char> buf(plain_block);
     while (true)
     {
-        fin.read(reinterpret_cast<char *>(cbuf.data()), cipher_block);
+        fin.read(reinterpret_cast<char *>(buf.data()), (streamsize)plain_block);
+        streamsize got = fin.gcount();
+        if (got <= 0)
+            break;
+        if ((size_t)got < plain_block)
+            fill(buf.begin() + got, buf.end(), 0);
+        BigUInt<L> m = BigUInt<L>::from_bytes(buf.data(), plain_block);
+        ctx.pow(m, d).to_bytes(cbuf.data(), cipher_block);
+        fout.write(reinterpret_cast<const char *>(cbuf.data()), (streamsize)cipher_block);
+    }
+}
+
+// Расшифрование по китайской теореме об остатках: два возведения по модулям P и Q
+// (вдвое короче N, с показателями вдвое короче) вместо одного по N — примерно в 3-4 раза быстрее
+template <size_t L>
+static void rsa_decrypt_big_impl(const string &input_file, const string &output_file, const BigKeyText &key)
+{
+    constexpr size_t H = L / 2;
+    BigUInt<H> P = BigUInt<H>::from_hex(key.P), Q = BigUInt<H>::from_hex(key.Q);
+    BigUInt<L> N = mul_full(P, Q);
+    BigUInt<L> d = BigUInt<L>::from_hex(key.d);
+    if (d.bit_length() > 32)
+        throw runtime_error("rsa_decrypt: public exponent d must fit in 32 bits");
+
+    ifstream fin(input_file, ios::binary);
+    ofstream fout(output_file, ios::binary);
+    if (!fin)
+        throw runtime_error("rsa_decrypt: cannot open input");
+    if (!fout)
+        throw runtime_error("rsa_decrypt: cannot open output");
+
+    char magic[4];
+    fin.read(magic, 4);
+    if (fin.gcount() != 4 || strncmp(magic, "RSA2", 4) != 0)
+        throw runtime_error("rsa_decrypt: bad format");
+    size_t plain_block = (unsigned char)fin.get();
+    plain_block |= (size_t)(unsigned char)fin.get() << 8;
+    size_t cipher_block = (unsigned char)fin.get();
+    cipher_block |= (size_t)(unsigned char)fin.get() << 8;
+    ull orig_size = read_le64(fin);
+    if (cipher_block == 0 || cipher_block > 8 * L || plain_block >= cipher_block)
+        throw runtime_error("rsa_decrypt: bad block sizes");
+    vector<unsigned char> cbuf(cipher_block);
+    fin.read(reinterpret_cast<char *>(cbuf.data()), (streamsize)cipher_block);
+    if (fin.gcount() != (streamsize)cipher_block || BigUInt<L>::from_bytes(cbuf.data(), cipher_block) != N)
+        throw runtime_error("rsa_decrypt: modulus N mismatch");
+
+    // dP = d^{-1} mod (P-1), dQ = d^{-1} mod (Q-1), qinv = Q^{-1} mod P (по Ферма)
+    BigMontgomery<H> ctxP(P), ctxQ(Q);
+    BigUInt<H> dP = inverse_small(d.limb[0], P - BigUInt<H>(1));
+    BigUInt<H> dQ = inverse_small(d.limb[0], Q - BigUInt<H>(1));
+    BigUInt<H> qinv_m = ctxP.to_mont(ctxP.pow(Q, P - BigUInt<H>(2)));
+
+    // x mod P для x < N = P*Q < P * 2^(64H): REDC даёт x * R^{-1}, умножение на R^2 — x
+    auto reduce_half = [](const BigMontgomery<H> &ctx, const BigUInt<L> &x)
+    {
+        BigUInt<L> t = x;
+        return ctx.mul(ctx.reduce(t.limb), ctx.r2);
+    };
+
+    vector<unsigned char> outb(plain_block);
+    ull written = 0;
+    while (written < orig_size)
+    {
+        fin.read(reinterpret_cast<char *>(cbuf.data()), (streamsize)cipher_block);
         streamsize got = fin.gcount();
         if (got == 0)
             break;
-        if (got != cipher_block)
+        if (got != (streamsize)cipher_block)
             throw runtime_error("rsa_decrypt: incomplete cipher block");
-        ull e_cipher = be_to_ull(cbuf);
-        // m = e_cipher^c mod N
-        long long e_ll = (long long)e_cipher;
-        long long N_ll = (long long)N;
-        long long m_ll = mod_pow(e_ll, c, N_ll);
-        ull m = (ull)m_ll;
-        auto outb = ull_to_be(m, (size_t)plain_block);
+        BigUInt<L> e = BigUInt<L>::from_bytes(cbuf.data(), cipher_block);
+        if (e >= N)
+            throw runtime_error("rsa_decrypt: cipher block is not less than N");
+
+        BigUInt<H> mp = ctxP.pow(reduce_half(ctxP, e), dP);
+        BigUInt<H> mq = ctxQ.pow(reduce_half(ctxQ, e), dQ);
+        // m = mq + Q * ((mp - mq) * qinv mod P)
+        BigUInt<H> h = ctxP.from_mont(ctxP.mul(ctxP.sub(ctxP.to_mont(mp), ctxP.to_mont(mq)), qinv_m));
+        BigUInt<L> m = mul_full(Q, h) + mq.template resize<L>();
+
+        m.to_bytes(outb.data(), plain_block);
         ull remain = orig_size - written;
         size_t towrite = (size_t)min<ull>((ull)plain_block, remain);
         fout.write(reinterpret_cast<const char *>(outb.data()), (streamsize)towrite);
         written += towrite;
-        if (written >= orig_size)
-            break;
     }
 }
 
+// Выбор ширины слова по длине ключа
+static void generate_rsa_keys_big(const string &key_file, int bits)
+{
+    if (bits < 256 || bits > 4096 || bits % 2 != 0)
+        throw runtime_error("genkeys_big: bits must be even and in [256, 4096]");
+    if (bits <= 1024)
+        generate_rsa_keys_big_impl<16>(key_file, bits);
+    else if (bits <= 2048)
+        generate_rsa_keys_big_impl<32>(key_file, bits);
+    else
+        generate_rsa_keys_big_impl<64>(key_file, bits);
+}
+
+static void rsa_encrypt_big(const string &input_file, const string &output_file, const string &key_file)
+{
+    BigKeyText key = load_big_keyfile(key_file);
+    if (key.bits <= 1024)
+        rsa_encrypt_big_impl<16>(input_file, output_file, key);
+    else if (key.bits <= 2048)
+        rsa_encrypt_big_impl<32>(input_file, output_file, key);
+    else if (key.bits <= 4096)
+        rsa_encrypt_big_impl<64>(input_file, output_file, key);
+    else
+        throw runtime_error("rsa_encrypt: key is too long");
+}
+
+static void rsa_decrypt_big(const string &input_file, const string &output_file, const string &key_file)
+{
+    BigKeyText key = load_big_keyfile(key_file);
+    if (key.bits <= 1024)
+        rsa_decrypt_big_impl<16>(input_file, output_file, key);
+    else if (key.bits <= 2048)
+        rsa_decrypt_big_impl<32>(input_file, output_file, key);
+    else if (key.bits <= 4096)
+        rsa_decrypt_big_impl<64>(input_file, output_file, key);
+    else
+        throw runtime_error("rsa_decrypt: key is too long");
+}
+
 // --------------------- main ---------------------
 int main(int argc, char *argv[])
 {
     if (argc < 2)
     {
         cerr << "Usage:\n  " << argv[0] << " genkeys <key_file> [min_prime] [max_prime]\n"
+             << "  " << argv[0] << " genkeys_big <key_file> [bits]\n"
              << "  " << argv[0] << " encrypt <in> <out> <key_file>\n"
              << "  " << argv[0] << " decrypt <in> <out> <key_file>\n";
         return 1;
@@ -289,6 +563,17 @@ int main(int argc, char *argv[])
             generate_rsa_keys(argv[2], minp, maxp);
             cout << "keys saved to " << argv[2] << "\n";
         }
+        else if (cmd == "genkeys_big")
+        {
+            if (argc < 3)
+            {
+                cerr << "genkeys_big <key_file> [bits]\n";
+                return 1;
+            }
+            int bits = (argc > 3) ? stoi(argv[3]) : 2048;
+            generate_rsa_keys_big(argv[2], bits);
+            cout << "keys saved to " << argv[2] << "\n";
+        }
         else if (cmd == "encrypt")
         {
             if (argc < 5)
@@ -296,6 +581,12 @@ int main(int argc, char *argv[])
                 cerr << "encrypt <in> <out> <key_file>\n";
                 return 1;
             }
+            if (is_big_keyfile(argv[4]))
+            {
+                rsa_encrypt_big(argv[2], argv[3], argv[4]);
+                cout << "encrypted\n";
+                return 0;
+            }
             ll P, Q, d, c;
             tie(P, Q, d, c) = load_keyfile(argv[4]);
             ull N = (ull)P * (ull)Q;
@@ -310,6 +601,12 @@ int main(int argc, char *argv[])
                 cerr << "decrypt <in> <out> <key_file>\n";
                 return 1;
             }
+            if (is_big_keyfile(argv[4]))
+            {
+                rsa_decrypt_big(argv[2], argv[3], argv[4]);
+                cout << "decrypted\n";
+                return 0;
+            }
             ll P, Q, d, c;
             tie(P, Q, d, c) = load_keyfile(argv[4]);
             ull N = (ull)P * (ull)Q;
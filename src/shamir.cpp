@@ -6,7 +6,6 @@
 #include <stdexcept>
 #include <cstring>
 #include <random>
-#include <chrono>
 #include <tuple>
 
 using ull = unsigned long long;
@@ -63,13 +62,6 @@ static int bytes_needed_for_value(ull x)
     return b ? b : 1;
 }
 
-// --- генерация пары (c,d) для Шамира. Используем mt19937_64 ---
-static std::mt19937_64 &global_rng()
-{
-    static std::mt19937_64 rng((unsigned)std::chrono::high_resolution_clock::now().time_since_epoch().count());
-    return rng;
-}
-
 std::tuple<ll, ll> generate_shamir_keys(ll p)
 {
     if (p <= 3)
@@ -79,17 +71,11 @@ std::tuple<ll, ll> generate_shamir_keys(ll p)
 
     for (int attempts = 0; attempts < 1000000; ++attempts)
     {
-        ull c = dist(global_rng());
-        // проверяем взаимную простоту
-        auto eg = egcd((long long)c, (long long)phi);
-        ll g = std::get<0>(eg);
-        ll x = std::get<1>(eg);
-        if (g != 1)
-            continue;
-        // d = x mod phi
-        ll d = (ll)(x % (ll)phi);
+        ull c = dist(crypto_rng());
+        // d = c^{-1} mod phi; -1 — c и phi не взаимно просты
+        ll d = mod_inverse((long long)c, (long long)phi);
         if (d < 0)
-            d += (ll)phi;
+            continue;
         // проверка: c * d % phi == 1
         ull check = (((__int128)c * (ull)d) % phi);
         if (check != 1ULL)
@@ -132,27 +118,45 @@ void shamir_encrypt(const std::string &input_file, const std::string &output_fil
     fin.seekg(0, std::ios::beg);
     write_le64(fout, orig_size);
 
+    // Шаги Шамира x1 = m^cA, x2 = x1^cB, x3 = x2^dA для простого p сворачиваются
+    // в одну степень: x3 = m^(cA*cB*dA mod (p-1)) — одно возведение вместо трёх.
+    // Показатель перекодируется один раз на файл, блоки обрабатываются пачками
+    ull phi = (ull)(p - 1);
+    ull chain = (ull)((unsigned __int128)((unsigned __int128)(ull)cA * (ull)cB % phi) * (ull)dA % phi);
+    FixedExpPow step_chain((ll)chain, p);
+    const size_t BATCH = 4096;
     std::vector<unsigned char> inbuf(plain_block);
-    while (true)
+    std::vector<ull> blocks;
+    blocks.reserve(BATCH);
+    bool eof = false;
+    while (!eof)
     {
-        fin.read(reinterpret_cast<char *>(inbuf.data()), (std::streamsize)plain_block);
-        std::streamsize got = fin.gcount();
-        if (got <= 0)
-            break;
-        if ((size_t)got < plain_block)
-            std::fill(inbuf.begin() + got, inbuf.end(), 0);
+        blocks.clear();
+        while (blocks.size() < BATCH)
+        {
+            fin.read(reinterpret_cast<char *>(inbuf.data()), (std::streamsize)plain_block);
+            std::streamsize got = fin.gcount();
+            if (got <= 0)
+            {
+                eof = true;
+                break;
+            }
+            if ((size_t)got < plain_block)
+                std::fill(inbuf.begin() + got, inbuf.end(), 0);
 
-        ull m = bytes_to_ull(inbuf);
-        if (m >= (ull)p)
-            throw std::runtime_error("Message block is too large for prime p");
+            ull m = bytes_to_ull(inbuf);
+            if (m >= (ull)p)
+                throw std::runtime_error("Message block is too large for prime p");
+            blocks.push_back(m);
+        }
 
-        // Шаги Шамира
-        ll x1 = mod_pow((long long)m, cA, p);
-        ll x2 = mod_pow(x1, cB, p);
-        ll x3 = mod_pow(x2, dA, p);
+        step_chain.pow_batch(blocks.data(), blocks.data(), blocks.size());
 
-        auto enc_bytes = ull_to_bytes((ull)x3, cipher_block);
-        fout.write(reinterpret_cast<const char *>(enc_bytes.data()), (std::streamsize)cipher_block);
+        for (ull x3 : blocks)
+        {
+            auto enc_bytes = ull_to_bytes(x3, cipher_block);
+            fout.write(reinterpret_cast<const char *>(enc_bytes.data()), (std::streamsize)cipher_block);
+        }
     }
 }
 
@@ -182,28 +186,43 @@ void shamir_decrypt(const std::string &input_file, const std::string &output_fil
         throw std::runtime_error("Prime p mismatch between key and cipher file");
     }
 
+    FixedExpPow step_dB(dB, p);
+    const size_t BATCH = 4096;
     std::vector<unsigned char> inbuf(cipher_block);
+    std::vector<ull> blocks;
+    blocks.reserve(BATCH);
     ull written = 0;
-    while (true)
+    bool eof = false;
+    while (!eof)
     {
-        fin.read(reinterpret_cast<char *>(inbuf.data()), cipher_block);
-        std::streamsize got = fin.gcount();
-        if (got <= 0)
-            break;
-        if ((size_t)got != (size_t)cipher_block)
-            throw std::runtime_error("Incomplete cipher block");
+        blocks.clear();
+        while (blocks.size() < BATCH)
+        {
+            fin.read(reinterpret_cast<char *>(inbuf.data()), cipher_block);
+            std::streamsize got = fin.gcount();
+            if (got <= 0)
+            {
+                eof = true;
+                break;
+            }
+            if ((size_t)got != (size_t)cipher_block)
+                throw std::runtime_error("Incomplete cipher block");
+            blocks.push_back(bytes_to_ull(inbuf));
+        }
 
-        ull x3 = bytes_to_ull(inbuf);
         // шаг 4: apply dB
-        ll m_ll = mod_pow((long long)x3, dB, p);
-        ull m = (ull)m_ll;
-        auto outb = ull_to_bytes(m, (size_t)plain_block);
+        step_dB.pow_batch(blocks.data(), blocks.data(), blocks.size());
+
+        for (ull m : blocks)
+        {
+            auto outb = ull_to_bytes(m, (size_t)plain_block);
 
-        // trim if last block
-        ull remain = orig_size - written;
-        size_t towrite = (size_t)std::min<ull>((ull)plain_block, remain);
-        fout.write(reinterpret_cast<const char *>(outb.data()), (std::streamsize)towrite);
-        written += towrite;
+            // trim if last block
+            ull remain = orig_size - written;
+            size_t towrite = (size_t)std::min<ull>((ull)plain_block, remain);
+            fout.write(reinterpret_cast<const char *>(outb.data()), (std::streamsize)towrite);
+            written += towrite;
+        }
     }
 }
 
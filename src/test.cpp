@@ -68,6 +68,38 @@ int main()
             p = 23;
             std::cout << "[mod_pow] " << a << "^" << x << " mod " << p
                       << " = " << mod_pow(a, x, p) << std::endl; // можно проверить руками/калькулятором
+
+            // ModInt (lib/modint.h): Монтгомери в ширине 32/64/128 бит
+            auto check = [](const char *name, bool ok)
+            {
+                cout << "[ModInt] " << name << (ok ? "  OK" : "  ОШИБКА") << endl;
+            };
+
+            // модуль — константа компиляции: 998244353 = 119 * 2^23 + 1, образующая 3
+            using Mod998 = StaticModInt<32, 998244353>;
+            static_assert(Mod998(2).pow(10).val() == 1024, "StaticModInt: 2^10");
+            static_assert(Mod998(3).pow(998244352).val() == 1, "StaticModInt: Ферма");
+            static_assert((Mod998(3).pow(499122176) + Mod998(1)).val() == 0, "StaticModInt: 3 — невычет");
+            check("StaticModInt<32, 998244353>: 2^10, 3^(p-1), 3^((p-1)/2) = -1 (static_assert)", true);
+
+            // 2^64 - 59 — наибольшее простое меньше 2^64
+            const uint64_t p64 = 18446744073709551557ULL;
+            ModInt<64>::set_mod(p64);
+            ModInt<64> m1(p64 - 1);
+            check("ModInt<64> mod 2^64-59: (-1)^2 = 1", (m1 * m1).val() == 1 && (-m1).val() == 1);
+            check("ModInt<64> mod 2^64-59: 5 * 5^-1 = 1", (ModInt<64>(5) * ModInt<64>(5).inv()).val() == 1);
+            check("ModInt<64> и mod_pow_u64 совпадают",
+                  ModInt<64>(123456789).pow(987654321ULL).val() == mod_pow_u64(123456789, 987654321ULL, p64));
+
+            // простое Мерсенна 2^127 - 1
+            const unsigned __int128 m127 = ((unsigned __int128)1 << 127) - 1;
+            ModInt<128>::set_mod(m127);
+            ModInt<128> two(2), three(3);
+            check("ModInt<128> mod 2^127-1: 2^127 = 1", two.pow(127).val() == 1);
+            check("ModInt<128> mod 2^127-1: 3^(p-1) = 1", three.pow(m127 - 1).val() == 1);
+            check("ModInt<128> mod 2^127-1: 3 * 3^-1 = 1", (three * three.inv()).val() == 1);
+            check("ModInt<128> mod 2^127-1: 2^126 + 2^126 = 1", (two.pow(126) + two.pow(126)).val() == 1);
+            check("ModInt<128> mod 2^127-1: 2 - 3 = p - 1", (two - three).val() == m127 - 1);
             waitForAnyKey();
             break;
         }
@@ -100,25 +132,74 @@ int main()
         case 4:
         {
             // === ТЕСТ 4: Поиск дискретного логарифма ===
+            // expected — наименьший x >= 0 (решатели возвращают x из [0, порядок a)), -1 — решения нет
             struct TestCase
             {
                 long long a, y, p, expected;
             };
 
+            auto check = [](const char *name, const TestCase &t, long long result)
+            {
+                cout << "  " << name << ": a=" << t.a << ", y=" << t.y << ", p=" << t.p
+                     << " -> x=" << result;
+                if (result == t.expected)
+                    cout << "  OK" << endl;
+                else
+                    cout << "  ОШИБКА (ожидалось " << t.expected << ")" << endl;
+            };
+
             TestCase tests[] = {
                 {2, 9, 11, 6},   // 2^6 mod 11 = 64 mod 11 = 9
                 {3, 10, 13, -1}, // нет такого x, что 3^x mod 13 = 10
                 {5, 8, 23, 6},   // 5^6 mod 23 = 8
                 {2, 1, 7, 0},    // 2^0 mod 7 = 1
+                {4, 5, 11, 2},   // 4 порядка 5: 4^7 = 4^2 = 5 mod 11
+                {1000002, 1000002, 1000003, 1}, // -1 порядка 2: шаги младенца обрываются на порядке
             };
 
             cout << "\n[Baby-Step Giant-Step] тестирование:\n";
 
             for (auto t : tests)
+                check("bsgs", t, bsgs(t.a, t.y, t.p));
+
+            try
+            {
+                // 3 — образующая по модулю 65537 = 2^16 + 1, 9 — квадрат (3 не лежит в <9>)
+                cout << "\n[Pohlig-Hellman / bsgs с гладким p - 1]:\n";
+                TestCase ph[] = {{3, 40360, 65537, 12345}, {9, 3, 65537, -1}};
+                for (auto t : ph)
+                {
+                    check("dlog_pohlig_hellman", t, dlog_pohlig_hellman(t.a, t.y, t.p));
+                    check("bsgs", t, bsgs(t.a, t.y, t.p));
+                }
+
+                // 2 — образующая по модулю 1000003, 4 — квадрат (2 не лежит в <4>)
+                cout << "\n[ро-метод, параллельный BSGS, таблица DlogTable]:\n";
+                TestCase mid[] = {{2, 155159, 1000003, 654321}, {4, 2, 1000003, -1}};
+                for (auto t : mid)
+                {
+                    check("dlog_rho", t, dlog_rho(t.a, t.y, t.p));
+                    check("bsgs_parallel", t, bsgs_parallel(t.a, t.y, t.p, 2));
+                    DlogTable table(t.a, t.p);
+                    check("DlogTable::solve", t, table.solve(t.y));
+                }
+
+                cout << "\n[метод кенгуру]:\n";
+                TestCase in_range = {2, 93703, 1000003, 500123};
+                check("dlog_kangaroo [500000, 501000]", in_range, dlog_kangaroo(2, 93703, 1000003, 500000, 501000));
+                TestCase out_of_range = {2, 93703, 1000003, -1};
+                check("dlog_kangaroo [0, 1000]", out_of_range, dlog_kangaroo(2, 93703, 1000003, 0, 1000));
+
+                // p = 2q + 1 — 50-битное безопасное простое, 2 — образующая, 4 — квадрат
+                cout << "\n[индексное исчисление]:\n";
+                TestCase ic[] = {{2, 947334933886640, 1126631251834643, 987654321012345},
+                                 {4, 2, 1126631251834643, -1}};
+                for (auto t : ic)
+                    check("dlog_index_calculus", t, dlog_index_calculus(t.a, t.y, t.p));
+            }
+            catch (const exception &e)
             {
-                long long result = bsgs(t.a, t.y, t.p);
-                cout << "a=" << t.a << ", y=" << t.y << ", p=" << t.p
-                     << " -> x=" << result << endl;
+                cerr << "Ошибка: " << e.what() << endl;
             }
             waitForAnyKey();
             break;
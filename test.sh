@@ -7,10 +7,10 @@ BUILD_DIR=build
 mkdir -p $BUILD_DIR
 
 echo "[1/3] Компиляция библиотеки..."
-g++ -fPIC -shared lib/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2
+g++ -fPIC -shared lib/cryptography.cpp -o $BUILD_DIR/libcryptography.so -std=c++17 -Wall -O2 -pthread
 
 echo "[2/3] Компиляция исполняемого файла..."
-g++ src/test.cpp -Ilib -L$BUILD_DIR -lcryptography -o $BUILD_DIR/test -std=c++17 -Wall -O2
+g++ src/test.cpp -Ilib -L$BUILD_DIR -lcryptography -o $BUILD_DIR/test -std=c++17 -Wall -O2 -pthread
 
 echo "[3/3] Запуск программы..."
 LD_LIBRARY_PATH=$BUILD_DIR $BUILD_DIR/test